@@ -1,49 +1,258 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
 
 #include "cpu_scheduler.h"
 
+#if !defined(NO_SIMD) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define USE_X86_SIMD    // AVX2/SSE4.1 kernels, picked at runtime
+#endif
+
 // global constants
-#define MAX_PROCESS 20
 #define MAX_ARRIVAL_TIME 20
-#define MAX_PRIORITY 4
 #define DEFAULT_PRIORITY 0
 #define MAX_CPU_BURST 20
 #define DEFAULT_CPU_BURST 10
 #define DEFAULT_IO_BURST 2
 #define DEFAULT_IO_START 1
 
-#define MAX_TIME 500
-// global clock variable
+// event log: a LogRec is stored (not formatted) if the table's log level covers the type.
+// compile with -DNO_EVENT_LOG to remove logging entirely
+#ifdef NO_EVENT_LOG
+#define LOG_EVENT(tbl, clk, type, pid, pid2, a0, a1, a2, arg) do{}while(0)
+#else
+#define LOG_EVENT(tbl, clk, type, pid, pid2, a0, a1, a2, arg) do{ \
+    if((tbl)->log != NULL && (tbl)->log->level >= (((type) == LOG_IDLE || (type) == LOG_IDLE_SPAN) ? 2 : 1)){ \
+        log_event((tbl)->log, (clk), (tbl)->core_id, (type), (pid), (pid2), (a0), (a1), (a2), (arg)); \
+    } }while(0)
+#endif
+
+// every policy (POLICIES, cpu_scheduler.h) gets its own copy of the simulation loops with the hooks inlined
+// (_run_tick_<name>() ...)
 
-int gannt[MAX_TIME] = {0};
+// forces the hooks into the loops even where the compiler would not inline them by itself,
+// so the algo argument is a constant there and every test on it folds away
+#ifdef __GNUC__
+#define ALWAYS_INLINE static inline __attribute__((always_inline))
+#else
+#define ALWAYS_INLINE static inline
+#endif
 
 // FUNCTIONS //
 
-Process** create_process(Config *cfg){
+ALWAYS_INLINE bool _preemptive(const int algo){
+    /* true if `algo` preempts: a process back from I/O always goes to the ready queue */
+    switch(algo){
+#define X(id, name, label, title, charge, timers, preempt, prio, quantum, queue) case id: return preempt;
+        POLICIES(X)
+#undef X
+    }
+    return false;
+}
+
+
+static bool _uses_priority(int algo){
+    /* true if `algo` selects by priority (or weights by it): processes get random priorities */
+    switch(algo){
+#define X(id, name, label, title, charge, timers, preempt, prio, quantum, queue) case id: return prio;
+        POLICIES(X)
+#undef X
+    }
+    return false;
+}
+
+
+static bool _uses_quantum(int algo){
+    /* true if `algo` uses Config.quantum (other algorithms are run once per sweep/benchmark point) */
+    switch(algo){
+#define X(id, name, label, title, charge, timers, preempt, prio, quantum, queue) case id: return quantum;
+        POLICIES(X)
+#undef X
+    }
+    return false;
+}
+
+
+static int _policy_queue(int algo){
+    /* Queue.type of the ready queue of `algo` (1, 2: selection by key, see _ready_q_type()) */
+    switch(algo){
+#define X(id, name, label, title, charge, timers, preempt, prio, quantum, queue) case id: return queue;
+        POLICIES(X)
+#undef X
+    }
+    return 0;
+}
+
+
+static const char* _algo_name(int algo, bool long_name){
+    /* short (label) or long (title) name of `algo`, "?" if there is no such algorithm */
+    switch(algo){
+#define X(id, name, label, title, charge, timers, preempt, prio, quantum, queue) case id: return long_name ? title : label;
+        POLICIES(X)
+#undef X
+    }
+    return "?";
+}
+
+static inline int _deadline_of(double factor, int cpu_burst){
+    /* relative deadline factor x CPU burst (Config.deadline_factor), 0: no deadline */
+    if(factor <= 0){
+        return 0;
+    }
+    double d = factor*cpu_burst + 0.5;
+    return (d < 1) ? 1 : (d > INT_MAX) ? INT_MAX : (int)d;
+}
+
+
+void create_process(Table* tbl, Config *cfg){
     /* 
-    Creates a number of processes as specified and returns a job pool */
+    Creates a number of processes as specified and stores the job pool in tbl->new_pool,
+    sorted by arrival time (processes arriving at the same clk keep their creation order).
+    All processes live in one block (tbl->proc_block) instead of one allocation each,
+    and so do their I/O bursts (tbl->io_block, Config.io_bursts per process) */
     
     int count = cfg->num_process;
+    int max_io = (cfg->io_bursts > 1) ? cfg->io_bursts : 1;
     Process **new_pool = (Process**) malloc(sizeof(Process*)*count);
+    Process *block = (Process*) malloc(sizeof(Process)*count);
+    IoBurst *io_block = (IoBurst*) malloc(sizeof(IoBurst)*count*max_io);
     
     // create processes and store them in new_pool
+    bool stat = cfg->arrival_dist != 0 || cfg->burst_dist != 0;
+    for(int i=0; i<MAX_PRIORITY; i++){
+        stat = stat || (cfg->use_priority && cfg->prio_weights[i] != 0);
+    }
+    if(cfg->num_tasks > 0){
+        // jobs of a periodic task set (the same set admission_test() checks: make_task_set() draws first)
+        Task tasks[MAX_TASKS];
+        int n = make_task_set(cfg, &tbl->rng, tasks);
+        generate_task_jobs(cfg, tasks, n, block, io_block, count);
+        stat = true;
+    }
+    else if(stat){
+        generate_processes(cfg, &tbl->rng, block, io_block, count, max_io);
+    }
     for(int i=0; i<count; i++){
-        new_pool[i] = _create_process(cfg);
+        new_pool[i] = stat ? &block[i] : _create_process(cfg, &tbl->rng, &block[i], &io_block[(long long)i*max_io]);
+        if(cfg->num_tasks == 0){
+            new_pool[i]->deadline = _deadline_of(cfg->deadline_factor, new_pool[i]->cpu_burst_init);
+        }
     }
+    // devices come from their own generator, so the workload is the same for any number of devices
+    if(cfg->num_devices > 1){
+        Rng dev_rng;
+        rng_seed(&dev_rng, (uint64_t)cfg->seed ^ 0x10d0d0d0ULL);
+        for(int i=0; i<count; i++){
+            for(int j=0; j<block[i].io_cnt; j++){
+                block[i].io_seq[j].dev = rng_below(&dev_rng, cfg->num_devices);
+            }
+            block[i].io_dev = (block[i].io_cnt > 0) ? block[i].io_seq[0].dev : 0;
+        }
+    }
+    sort_by_arrival(new_pool, count);
     
-    return new_pool;
+    tbl->new_pool = new_pool;
+    tbl->pool_cnt = count;
+    tbl->proc_block = block;
+    tbl->io_block = io_block;
+}
+
+
+void sort_by_arrival(Process** pool, int count){
+    /*
+    Stable sort of pool by arrival_time, so admission order within a clk is deterministic.
+    Bottom-up merge sort, or a counting sort when there are fewer distinct arrival times than processes
+    */
+    if(count < 2){
+        return;
+    }
+    bool sorted = true;
+    long long lo = pool[0]->arrival_time, hi = lo;
+    for(int i=1; i<count; i++){
+        long long t = pool[i]->arrival_time;
+        sorted = sorted && pool[i-1]->arrival_time <= t;
+        lo = (t < lo) ? t : lo;
+        hi = (t > hi) ? t : hi;
+    }
+    if(sorted){ // already in order (e.g. Poisson arrivals)
+        return;
+    }
+    Process **buf = (Process**) malloc(sizeof(Process*)*count);
+    if(hi - lo < count){
+        // few distinct arrival times (uniform arrivals): stable counting sort
+        int range = (int)(hi - lo) + 1;
+        int *pos = (int*) calloc(range + 1, sizeof(int));
+        for(int i=0; i<count; i++){
+            pos[pool[i]->arrival_time - lo + 1]++;
+        }
+        for(int i=1; i<=range; i++){
+            pos[i] += pos[i-1];
+        }
+        for(int i=0; i<count; i++){
+            buf[pos[pool[i]->arrival_time - lo]++] = pool[i];
+        }
+        memcpy(pool, buf, sizeof(Process*)*count);
+        free(pos);
+        free(buf);
+        return;
+    }
+    Process **src = pool;
+    Process **dst = buf;
+
+    for(int width=1; width<count; width*=2){
+        for(int lo=0; lo<count; lo+=2*width){
+            int mid = (lo+width < count) ? lo+width : count;
+            int hi = (lo+2*width < count) ? lo+2*width : count;
+            int i = lo, j = mid, k = lo;
+            while(i < mid && j < hi){
+                // take from the left run on ties (stable)
+                dst[k++] = (src[j]->arrival_time < src[i]->arrival_time) ? src[j++] : src[i++];
+            }
+            while(i < mid){dst[k++] = src[i++];}
+            while(j < hi){dst[k++] = src[j++];}
+        }
+        Process **tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+    if(src != pool){    // result ended up in buf
+        for(int i=0; i<count; i++){
+            pool[i] = src[i];
+        }
+    }
+    free(buf);
 }
 
-Process* _create_process(Config *cfg){
+static void _reset_process(Process* p);
+static void _init_process(Config *cfg, Rng* rng, Process* p, IoBurst* io_mem);
+
+
+Process* _create_process(Config *cfg, Rng* rng, Process* new_process, IoBurst* io_mem){
     /* 
-    Create a process (struct Process)
+    Create a process (struct Process) in the memory pointed to by new_process
     
     Parameters
     ----------
     Config *cfg: pointer to Config struct which determines whether to randomise process attributes or not
 
+    Rng *rng: random number generator of the simulation (Table.rng)
+
+    Process *new_process: where to create the process (a slot of Table.proc_block)
+
+    IoBurst *io_mem: room for Config.io_bursts I/O bursts (a slice of Table.io_block)
+
     Returns
     -------
     Process *new_process: pointer to new process with attributes...
@@ -63,812 +272,6105 @@ Process* _create_process(Config *cfg){
 
     ... io_burst_rem: (1 ~ cpu_burst_init/2) number of I/O burst cycles remaining (0 if cpu burst is 1)
 
+    ... io_seq: up to Config.io_bursts I/O bursts, each after at least one more CPU clk than the previous one
+                (the first one is io_burst_start/io_burst_rem), on device 0 (create_process() picks the devices)
+
     ... state: 0=new, 1=ready, 2=running, 3=waiting, 4=terminated
     
     ... time related attributes are initialised to 0
      */
-    
-    Process *new_process = (Process*) malloc(sizeof(Process));
-    
 
-    new_process->pid = rand()%8999 + 1001; // 1001 ~ 9999
-    new_process->arrival_time = cfg->rand_arrival ? rand()%MAX_ARRIVAL_TIME + 1 : 0;
-    new_process->priority = cfg->use_priority ? rand()%MAX_PRIORITY + 1 : DEFAULT_PRIORITY;
-    new_process->cpu_burst_init = cfg->rand_cpu_burst ? rand()%MAX_CPU_BURST + 1 : DEFAULT_CPU_BURST;
-    new_process->cpu_burst_rem = new_process->cpu_burst_init;
-    if(new_process->cpu_burst_init == 1){
-        new_process->io_burst_start = -1;
-        new_process->io_burst_rem = 0;
+    new_process->pid = rng_below(rng, 8999) + 1001; // 1001 ~ 9999
+    new_process->arrival_time = cfg->rand_arrival ? rng_below(rng, MAX_ARRIVAL_TIME) + 1 : 0;
+    new_process->priority = cfg->use_priority ? rng_below(rng, MAX_PRIORITY) + 1 : DEFAULT_PRIORITY;
+    new_process->cpu_burst_init = cfg->rand_cpu_burst ? rng_below(rng, MAX_CPU_BURST) + 1 : DEFAULT_CPU_BURST;
+    _init_process(cfg, rng, new_process, io_mem);
+
+    return new_process; // return pointer to new process
+}
+
+
+static void _init_process(Config *cfg, Rng* rng, Process* p, IoBurst* io_mem){
+    /* I/O bursts and the rest of a process whose pid, arrival_time, priority and cpu_burst_init are set */
+    p->cpu_burst_rem = p->cpu_burst_init;
+    p->io_seq = io_mem;
+    p->io_cnt = 0;
+    p->io_next = 0;
+    p->io_dev = 0;
+    p->deadline = 0;
+    p->period = 0;
+    if(p->cpu_burst_init == 1){
+        p->io_burst_start = -1;
+        p->io_burst_rem = 0;
     }
     else{
-        new_process->io_burst_start = cfg->rand_io_burst ? rand()%(new_process->cpu_burst_init-1) + 1 : DEFAULT_IO_START;
-        new_process->io_burst_rem = cfg->rand_io_burst ? rand()%(new_process->cpu_burst_init/2) + 1 : DEFAULT_IO_BURST;
+        p->io_burst_start = cfg->rand_io_burst ? rng_below(rng, p->cpu_burst_init-1) + 1 : DEFAULT_IO_START;
+        p->io_burst_rem = cfg->rand_io_burst ? rng_below(rng, p->cpu_burst_init/2) + 1 : DEFAULT_IO_BURST;
+        io_mem[0].gap = p->io_burst_start;
+        io_mem[0].len = p->io_burst_rem;
+        io_mem[0].dev = 0;
+        p->io_cnt = 1;
+        // further I/O bursts: each one needs at least one CPU clk after the previous one and before the end
+        int pos = p->io_burst_start;
+        while(p->io_cnt < cfg->io_bursts && pos < p->cpu_burst_init-1){
+            IoBurst *b = &io_mem[p->io_cnt++];
+            b->gap = cfg->rand_io_burst ? rng_below(rng, p->cpu_burst_init-1 - pos) + 1 : 1;
+            b->len = cfg->rand_io_burst ? rng_below(rng, p->cpu_burst_init/2) + 1 : DEFAULT_IO_BURST;
+            b->dev = 0;
+            pos += b->gap;
+        }
+        p->io_next = 1;
     }
-    new_process->state = 0; // new
+    _reset_process(p);
+}
 
-    // time related attributes are initialised to -1
-    new_process->ready_wait_time = 0;
-    new_process->io_wait_time = 0;
-    new_process->turnaround_time = 0;
-    new_process->finish_time = 0;
 
-    return new_process; // return pointer to new process
-}
+// statistical generators: log/exp/sin/cos are polynomials evaluated on whole arrays of GEN_BATCH values
+// (no libm, no branches and no int/double conversions, so the compiler can vectorize the loops)
+#define LN2 0.69314718055994530942
+#define ROUND_MAGIC 6755399441055744.0  // 1.5*2^52: (x + ROUND_MAGIC) - ROUND_MAGIC rounds x to an integer
+#define MAX_GEN_BURST 1000000   // heavy tails are cut here
+#define INTERACTIVE_BURST 2.0   // mean CPU burst of interactive processes (bimodal)
+
+typedef union{double d; uint64_t u;} Bits;
+
+// 1/k! for the sin/cos series
+static const double _cos_c[12] = {1.0, -1.0/2, 1.0/24, -1.0/720, 1.0/40320, -1.0/3628800, 1.0/479001600,
+    -1.0/87178291200.0, 1.0/20922789888000.0, -1.0/6402373705728000.0, 1.0/2432902008176640000.0, -1.0/1124000727777607680000.0};
+static const double _sin_c[12] = {1.0, -1.0/6, 1.0/120, -1.0/5040, 1.0/362880, -1.0/39916800, 1.0/6227020800.0,
+    -1.0/1307674368000.0, 1.0/355687428096000.0, -1.0/121645100408832000.0, 1.0/51090942171709440000.0, -1.0/25852016738884976640000.0};
+
 
-Queue* create_queue(){
+static inline double _fast_log(double x){
     /*
-    Create an empty Queue 
+    natural log of x >= 0 (finite): x = m * 2^k with m in [sqrt(1/2), sqrt(2)), log(m) = 2 atanh((m-1)/(m+1)).
+    k and m come from integer arithmetic on the bits (as in musl's log), so there is no branch
     */
-    Queue *new_queue = (Queue*)malloc(sizeof(Queue));
-    new_queue->head = NULL;
-    new_queue->tail = NULL;
-    new_queue->cnt = 0;
-
-    return new_queue;
+    Bits v = {x};
+    uint64_t t = v.u - 0x3fe6a09e667f3bcdULL;    // bits of sqrt(1/2)
+    Bits k = {.u = ((t + 0x3ff0000000000000ULL) >> 52) | 0x4330000000000000ULL};  // 2^52 + k + 1023
+    v.u -= t & 0xfff0000000000000ULL;
+    double m = (v.d - 1.0)/(v.d + 1.0);
+    double m2 = m*m;
+    double p = 1.0 + m2*(1.0/3 + m2*(1.0/5 + m2*(1.0/7 + m2*(1.0/9 + m2*(1.0/11 + m2*(1.0/13))))));
+    return 2.0*m*p + (k.d - 4503599627370496.0 - 1023.0)*LN2;
 }
 
 
-Table* create_table(Config *cfg){
-    /*
-    Create a Table which keeps track of all queues, running process, and current time
+static inline double _fast_exp(double x){
+    /* e^x for x in -708 ~ 708: 2^k * e^r with |r| <= ln2/2 */
+    Bits k = {x*(1.0/LN2) + ROUND_MAGIC};    // low bits hold k
+    double r = x - (k.d - ROUND_MAGIC)*LN2;
+    double p = 1.0 + r*(1.0 + r*(1.0/2 + r*(1.0/6 + r*(1.0/24 + r*(1.0/120 + r*(1.0/720 + r*(1.0/5040 +
+               r*(1.0/40320 + r*(1.0/362880 + r*(1.0/3628800 + r*(1.0/39916800)))))))))));
+    Bits s = {.u = (k.u + 1023) << 52};
+    return p * s.d;
+}
 
-    Attributes
-    ----------
-    Process** new_pool: array of pointers to processes (assigned by create_process() in main())
 
-    Queue* ready_q: queue of processes that are ready to be executed
+static inline double _fast_series(const double* c, double x2){
+    /* c[0] + c[1]*x2 + ... + c[11]*x2^11 */
+    return c[0] + x2*(c[1] + x2*(c[2] + x2*(c[3] + x2*(c[4] + x2*(c[5] + x2*(c[6] + x2*(c[7] +
+           x2*(c[8] + x2*(c[9] + x2*(c[10] + x2*c[11]))))))))));
+}
 
-    Queue* wait_q: queue of processes that are waiting for I/O to be completed
 
-    Queue* term_q: queue of processes that have terminated
+static void _gen_uniform(Rng* rng, double* u){
+    /* GEN_BATCH uniform doubles in (0, 1] (never 0, so log(u) is finite) */
+    for(int i=0; i<GEN_BATCH; i++){
+        Bits v = {.u = (rng_next(rng) >> 12) | 0x3ff0000000000000ULL};    // [1, 2)
+        u[i] = 2.0 - v.d;
+    }
+}
 
-    Process* running_p: pointer to process that is currently running
 
-    Process* io_p: pointer to process that is currently performing I/O (handled by CPU())
+static void _gen_exponential(Rng* rng, double* x, double mean){
+    /* GEN_BATCH exponential values with the given mean (inverse transform: -mean*log(u)) */
+    _gen_uniform(rng, x);
+    for(int i=0; i<GEN_BATCH; i++){
+        x[i] = -mean*_fast_log(x[i]);
+    }
+}
 
-    int clk: current time
 
-    int quantum: time quantum for Round Robin
-    */
+static void _gen_normal(Rng* rng, double* restrict z, double* restrict tmp){
+    /* GEN_BATCH standard normal values, two per pair of uniforms (Box-Muller: sqrt(-2 log u1) * cos/sin(2 pi u2)) */
+    const int half = GEN_BATCH/2;
+    _gen_uniform(rng, tmp);
+    for(int i=0; i<half; i++){
+        double r = _fast_exp(0.5*_fast_log(-2.0*_fast_log(tmp[i])));
+        double a = 6.28318530717958647692*(tmp[half+i] - 0.5);     // -pi ~ pi
+        double a2 = a*a;
+        z[i] = r*_fast_series(_cos_c, a2);
+        z[half+i] = r*a*_fast_series(_sin_c, a2);
+    }
+}
 
-    Table *new_table = (Table*)malloc(sizeof(Table));   
-    new_table->new_pool = NULL; // create_process() will create/allocate new_pool
-    new_table->ready_q = create_queue();
-    new_table->wait_q = create_queue();
-    new_table->term_q = create_queue();
-    new_table->running_p = NULL;
-    new_table->io_p = NULL;
-    new_table->clk = 0;
-    new_table->quantum = cfg->quantum;
 
-    return new_table;
+static void _gen_lognormal(Rng* rng, double* x, double* tmp, double mean, double sigma){
+    /* GEN_BATCH lognormal values exp(mu + sigma*z), mu chosen so that E[x] = mean */
+    double mu = _fast_log(mean) - sigma*sigma/2;
+    _gen_normal(rng, x, tmp);
+    for(int i=0; i<GEN_BATCH; i++){
+        x[i] = _fast_exp(mu + sigma*x[i]);
+    }
 }
 
-void arrived_to_ready(Table* tbl, int count){
-    /*
-    Check new_pool for processes that have arrived and enqueue them to ready_q
 
-    Parameters
-    ----------
-    int count: maximum length of new_pool (i.e. cfg->num_process)
+static void _gen_bimodal(Rng* rng, double* restrict x, double* restrict tmp, double frac, double mean, double sigma){
+    /*
+    GEN_BATCH bursts of an interactive/batch mix: with probability frac lognormal with mean INTERACTIVE_BURST
+    and sigma 0.5, otherwise lognormal with the given mean and sigma. The class is blended in without a branch
     */
-    Process **new_pool = tbl->new_pool;
-    Queue *ready_q = tbl->ready_q;
-
-    for(int i=0; i<count; i++){
-        if(new_pool[i]->arrival_time == tbl->clk){
-            // log message
-            printf("<@%d> ARRIVE: [%d] arrived to ready queue\n", tbl->clk, new_pool[i]->pid);
-            enqueue(ready_q, new_pool[i]);
-            new_pool[i]->state = 1; // ready
-        }
+    double mu_i = _fast_log(INTERACTIVE_BURST) - 0.125;
+    double mu_b = _fast_log(mean) - sigma*sigma/2;
+    _gen_normal(rng, x, tmp);
+    _gen_uniform(rng, tmp);
+    for(int i=0; i<GEN_BATCH; i++){
+        Bits d = {frac - tmp[i]};
+        Bits c = {.u = (d.u >> 63) | 0x4330000000000000ULL};     // 2^52 + (1: batch, 0: interactive)
+        double batch = c.d - 4503599627370496.0;
+        x[i] = _fast_exp(mu_i + batch*(mu_b - mu_i) + (0.5 + batch*(sigma - 0.5))*x[i]);
     }
 }
 
 
-void wait_to_ready(Table* tbl, int algo){
-    /* if I/O process is done, move to ready queue (or assign to CPU if non-preemptive) */
-    
-    if(tbl->io_p == NULL){
-        return;
-    }
-    if(tbl->io_p->io_burst_rem == 0){
-        if(algo == 2 || algo==4 || algo==5){    // if preemptive, move io_p to ready queue
-            printf("<@%d> I/O COMPLETE: [%d]\n", tbl->clk-1, tbl->io_p->pid);
-            printf("<@%d> READY: [%d] to ready queue\n", tbl->clk, tbl->io_p->pid);
-            tbl->io_p->state = 1;   // ready
-            enqueue(tbl->ready_q, tbl->io_p);
-            tbl->io_p = NULL;
-        }
-        else{   // if non-preemptive, running_p = io_p
-            printf("<@%d> I/O Complete: [%d]\n", tbl->clk-1, tbl->io_p->pid);
-            printf("<@%d> DISPATCH: [%d] to CPU from I/O\n", tbl->clk, tbl->io_p->pid);
-            tbl->io_p->state = 2;   // running
-            tbl->running_p = tbl->io_p;
-            tbl->io_p = NULL;
-        }
+static void _gen_pareto(Rng* rng, double* x, double mean, double alpha){
+    /* GEN_BATCH Pareto values xm * u^(-1/alpha), xm chosen so that E[x] = mean (alpha > 1) */
+    double xm = mean*(alpha - 1)/alpha;
+    _gen_uniform(rng, x);
+    for(int i=0; i<GEN_BATCH; i++){
+        x[i] = xm*_fast_exp(-_fast_log(x[i])/alpha);
     }
 }
 
-void enqueue(Queue *q, Process *p){
+
+void generate_processes(Config *cfg, Rng* rng, Process* block, IoBurst* io_block, int count, int max_io){
     /*
-    Create/allocate a new Node and assign a process to it
+    Statistical workload: fill block[0 ~ count-1] (and their I/O bursts in io_block) GEN_BATCH processes at a time.
+    Every attribute of a batch is drawn into an array first (arrivals, bursts, bimodal classes, priorities),
+    then the processes are put together. Deterministic for a given rng state.
+
+    arrivals (Config.arrival_dist): uniform 1 ~ MAX_ARRIVAL_TIME like _create_process(),
+                                    or a Poisson process (sorted, exponential gaps with mean Config.arrival_mean)
+    CPU bursts (Config.burst_dist): uniform, lognormal, Pareto (Config.burst_mean, Config.burst_shape)
+                                    or bimodal: interactive (lognormal, mean INTERACTIVE_BURST, sigma 0.5)
+                                    with probability Config.interactive_frac, otherwise a lognormal batch burst
+    priority: Config.prio_weights (all 0: uniform 1 ~ MAX_PRIORITY), DEFAULT_PRIORITY if priorities are not used
+    I/O bursts: as _create_process(), relative to the CPU burst
     */
+    double arr[GEN_BATCH], burst[GEN_BATCH], tmp[GEN_BATCH];
+    int prio_cum[MAX_PRIORITY], prio_total = 0;
+    for(int i=0; i<MAX_PRIORITY; i++){
+        prio_total += (cfg->prio_weights[i] > 0) ? cfg->prio_weights[i] : 0;
+        prio_cum[i] = prio_total;
+    }
+    double t = 0;   // Poisson process clock
 
-    Node *new_node = (Node*)malloc(sizeof(Node));
-    new_node->p = p;
+    for(int base=0; base<count; base+=GEN_BATCH){
+        int n = (count - base < GEN_BATCH) ? count - base : GEN_BATCH;
 
-    if(q->head == NULL){
-        q->head = new_node;
-        q->tail = new_node;
-        new_node->left = NULL;
-        new_node->right = NULL;
-    } // queue is empty
-    else{
-        q->tail->right = new_node;
-        new_node->left = q->tail;
-        new_node->right = NULL;
-        q->tail = new_node;
-    } // queue is not empty
-    q->cnt++;
+        if(cfg->arrival_dist == 1){
+            _gen_exponential(rng, arr, cfg->arrival_mean);
+            for(int i=0; i<n; i++){
+                t += arr[i];
+                arr[i] = t;
+            }
+        }
+        else{
+            for(int i=0; i<n; i++){
+                arr[i] = cfg->rand_arrival ? rng_below(rng, MAX_ARRIVAL_TIME) + 1 : 0;
+            }
+        }
+
+        switch(cfg->burst_dist){
+            case 1:
+                _gen_lognormal(rng, burst, tmp, cfg->burst_mean, cfg->burst_shape);
+                break;
+            case 2:
+                _gen_pareto(rng, burst, cfg->burst_mean, cfg->burst_shape);
+                break;
+            case 3:
+                _gen_bimodal(rng, burst, tmp, cfg->interactive_frac, cfg->burst_mean, cfg->burst_shape);
+                break;
+            default:
+                for(int i=0; i<n; i++){
+                    burst[i] = cfg->rand_cpu_burst ? rng_below(rng, MAX_CPU_BURST) + 1 : DEFAULT_CPU_BURST;
+                }
+        }
 
+        for(int i=0; i<n; i++){
+            Process *p = &block[base+i];
+            p->pid = rng_below(rng, 8999) + 1001;
+            p->arrival_time = (long long)arr[i];
+            p->priority = DEFAULT_PRIORITY;
+            if(cfg->use_priority){
+                if(prio_total > 0){
+                    int r = rng_below(rng, prio_total), j = 0;
+                    while(r >= prio_cum[j]){j++;}
+                    p->priority = j + 1;
+                }
+                else{
+                    p->priority = rng_below(rng, MAX_PRIORITY) + 1;
+                }
+            }
+            double b = burst[i] + 0.5;
+            p->cpu_burst_init = (b < 1) ? 1 : (b > MAX_GEN_BURST) ? MAX_GEN_BURST : (int)b;
+            _init_process(cfg, rng, p, &io_block[(long long)(base+i)*max_io]);
+        }
+    }
 }
 
 
-void dequeue(Queue* q, Process* p){
+// periodic task sets (EDF): UUniFast utilizations, log-uniform periods
+#define TASK_MIN_PERIOD 10
+#define TASK_MAX_PERIOD 1000
+#define QPA_MAX_HORIZON (1LL << 40)     // processor demand is checked up to here when the utilization is 1
+
+
+int make_task_set(Config* cfg, Rng* rng, Task* tasks){
     /*
-    Remove a node from the queue
+    Draw a set of Config.num_tasks (up to MAX_TASKS) periodic tasks into tasks[] and return their number.
+    The utilizations add up to Config.task_util (UUniFast: u_i = sum x (1 - r^(1/(n-i)))), the periods are
+    log-uniform in TASK_MIN_PERIOD ~ TASK_MAX_PERIOD, wcet = u_i x period (at least 1 clk) and
+    deadline = Config.task_deadline x period. Rounding moves the utilization a little off Config.task_util
     */
-    Node* curr = q->head;
-    // check if queue is empty
-    if(curr == NULL){
-        printf("Error: dequeue() called on empty queue\n");
-        exit(1);
+    int n = (cfg->num_tasks < MAX_TASKS) ? cfg->num_tasks : MAX_TASKS;
+    double u[GEN_BATCH], r[GEN_BATCH];
+    _gen_uniform(rng, u);
+    _gen_uniform(rng, r);
+    double lo = _fast_log(TASK_MIN_PERIOD), hi = _fast_log(TASK_MAX_PERIOD);
+    double sum = cfg->task_util;
+    for(int i=0; i<n; i++){
+        double next = (i < n-1) ? sum*_fast_exp(_fast_log(u[i])/(n-1-i)) : 0;
+        double period = _fast_exp(lo + (1.0 - r[i])*(hi - lo)) + 0.5;
+        tasks[i].period = (int)period;
+        double wcet = (sum - next)*tasks[i].period + 0.5;
+        tasks[i].wcet = (wcet < 1) ? 1 : (int)wcet;
+        double deadline = cfg->task_deadline*tasks[i].period + 0.5;
+        tasks[i].deadline = (deadline < 1) ? 1 : (deadline > INT_MAX) ? INT_MAX : (int)deadline;
+        sum = next;
     }
-    // search for the node to dequeue
-    while(curr != NULL){
-        if(curr->p == p){ // found the node to dequeue
-            if(curr == q->head && curr == q->tail){ // curr is head and tail, only node
-                q->head = NULL;
-                q->tail = NULL;
-                free(curr);
-                q->cnt--;
-                // q is now empty
-                if(q->cnt != 0){
-                    printf("Error: dequeue() empty queue's cnt is not 0\n");
-                    exit(1);
-                }
-                return;
-            } // if: curr is head and tail, only node
-            else if(curr == q->head){ // curr is head, not tail
-                q->head = curr->right;
-                q->head->left = NULL;
-                free(curr);
-                q->cnt--;
-                return;
-            } // if: curr is head, not tail
-            else if(curr == q->tail){ // curr is tail
-                q->tail = curr->left;
-                q->tail->right = NULL;
-                free(curr);
-                q->cnt--;
-                return;
-            } // if: curr is tail
-            else{ // curr is not head, not tail
-                curr->left->right = curr->right;
-                curr->right->left = curr->left;
-                free(curr);
-                q->cnt--;
-                return;
-            } // if: curr is not head, not tail
-        } // if: found the node to dequeue
-        curr = curr->right;
-    } // iterate through the queue
-    printf("Error: dequeue() couldn't find the process to dequeue\n");
-    exit(1);
+    return n;
 }
 
 
-void update_wait_time(Table* tbl){
+void generate_task_jobs(Config* cfg, Task* tasks, int num_tasks, Process* block, IoBurst* io_block, int count){
     /*
-    Increment Process.ready_wait_time for all processes in tbl.ready_q
+    Fill block[0 ~ count-1] with the first count jobs of the task set, in release order: every task releases
+    a job at clk 0 and then every period (synchronous release, the worst case for EDF). The jobs of task i
+    have pid 1001 + i, a CPU burst of its wcet and no I/O, and are due deadline clks after their release.
+    Jobs released at the same clk are in task order (EventQueue keyed on release x MAX_TASKS + task)
     */
+    int max_io = (cfg->io_bursts > 1) ? cfg->io_bursts : 1;
+    EventQueue *eq = create_event_queue(num_tasks);
+    for(int i=0; i<num_tasks; i++){
+        push_event(eq, i, 0, i);
+    }
+    for(int j=0; j<count; j++){
+        Event e = pop_event(eq);
+        Task *t = &tasks[e.pid];
+        long long release = e.time/MAX_TASKS;
+        Process *p = &block[j];
+        p->pid = 1001 + e.pid;
+        p->arrival_time = release;
+        p->priority = DEFAULT_PRIORITY;
+        p->cpu_burst_init = t->wcet;
+        p->cpu_burst_rem = t->wcet;
+        p->io_seq = &io_block[(long long)j*max_io];
+        p->io_cnt = 0;
+        p->io_next = 0;
+        p->io_dev = 0;
+        p->io_burst_start = -1;
+        p->io_burst_rem = 0;
+        p->deadline = t->deadline;
+        p->period = t->period;
+        _reset_process(p);
+        push_event(eq, (release + t->period)*MAX_TASKS + e.pid, 0, e.pid);
+    }
+    free(eq->heap);
+    free(eq);
+}
 
-    if(tbl->ready_q == NULL){
-        printf("<@%d> ERROR: update_wait_time() ready queue is empty but task not over\n", tbl->clk);
-        exit(1);
-    }   // just in case
 
-    Node* curr;    
-    // update wait time (ready queue)
-    curr = tbl->ready_q->head;
-    while(curr != NULL){
-        curr->p->ready_wait_time++;
-        curr = curr->right;
+static long long _task_demand(Task* tasks, int n, long long t){
+    /* processor demand bound: CPU clks of the jobs released at or after 0 and due by t (synchronous release) */
+    long long h = 0;
+    for(int i=0; i<n; i++){
+        if(t >= tasks[i].deadline){
+            h += ((t - tasks[i].deadline)/tasks[i].period + 1)*tasks[i].wcet;
+        }
     }
-    // update wait time (I/O)
-    curr = tbl->wait_q->head;
-    while(curr != NULL){
-        curr->p->io_wait_time++;
-        curr = curr->right;
+    return h;
+}
+
+
+static long long _last_deadline_before(Task* tasks, int n, long long t){
+    /* latest absolute deadline k x period + deadline < t (0: none) */
+    long long d = 0;
+    for(int i=0; i<n; i++){
+        if(t > tasks[i].deadline){
+            long long k = (t - 1 - tasks[i].deadline)/tasks[i].period;
+            long long di = k*tasks[i].period + tasks[i].deadline;
+            d = (di > d) ? di : d;
+        }
     }
+    return d;
 }
 
 
-int CPU(Table* tbl, int algo, int _quantum){
-    /* CPU()
-    1. Schedule: select a Process to execute according to the scheduling algorithm specified by `algo`
-        - if preemptive:
-            - if running_p is NULL: DISPATCH
-            - if running_p is not NULL: PREEMPT (if higher priority process in ready_q)
-        - if non-preemptive:
-            - if running_p is NULL and I/O is IDLE: DISPATCH
-            - if running_p is NULL but I/O is BUSY: WAIT
-            - if running_p is not NULL: keep running_p
-    
-    2. Compute:
-        - Decrement tbl->quantum (if algo == 5, i.e. Round Robin)
-        - Compute CPU burst for 1 CLK --> check if running_p is finished
-        - Decrement running_p->io_burst_start --> check if I/O must be serviced
-    
-    Parameters
-    ----------
-    Table* tbl: tbl keeps track of all queues, running process, current time and other options required for scheduling
+bool admission_test(Task* tasks, int n, double* util, double* density, long long* fail_at){
+    /*
+    EDF schedulability of a periodic task set on one CPU (exact for synchronous release).
 
-    int algo: specifies the scheduling algorithm to be used
-        0: FCFS
-        1: SJF w/o preemption
-        2: SJF w/ preemption
-        3: Priority w/o preemption
-        4: Priority w/ preemption
-        5: Round Robin - identical time quantum, no priority, always preempt
+    utilization U = sum(wcet/period) > 1: infeasible.
+    Every deadline >= period: feasible (U <= 1 is enough). Density sum(wcet/min(deadline, period)) <= 1: feasible.
+    Otherwise the processor demand h(t) must not exceed t at any absolute deadline t below
+    L = max(max deadline, sum((period - deadline) x U_i)/(1 - U)) (the hyperperiod, up to QPA_MAX_HORIZON, when U = 1).
+    QPA (Zhang and Burns) walks t down from L, jumping to h(t) when h(t) < t, so only a few deadlines are checked.
 
     Returns
     -------
-    int: -1 if CPU is IDLE
-          0 if running_p is finished (tbl->running_p == NULL)
-          else: tbl->running_p->cpu_burst_rem
-     */
-    
-    
-    
-    // schedule a Process to execute
-    Process* out;   // return of _SJF() or _PRIO()
-    switch(algo){
-        case 0: // FCFS
-            if(tbl->running_p == NULL && tbl->io_p == NULL){
-                if(tbl->ready_q->head == NULL){
-                    gannt[tbl->clk] = -1;
-                    // log message: IDLE
-                    printf("<@%d> IDLE: CPU and I/O are idle\n", tbl->clk);
-                    return -1;  // CPU and I/O IDLE: running_p == NULL
-                }
-                // DISPATCH
-                tbl->running_p = tbl->ready_q->head->p;
-                printf("<@%d> DISPATCH: [%d] to CPU\n", tbl->clk, tbl->running_p->pid);
-                tbl->running_p->state = 2;  // running
-                dequeue(tbl->ready_q, tbl->running_p);   
-            }
-            break;           
-        case 1: // SJF (non-preemptive)
-            if(tbl->running_p == NULL && tbl->io_p == NULL){
-                out = _SJF(tbl->ready_q);
-                if(out == NULL){
-                    gannt[tbl->clk] = -1;
-                    // log message: IDLE
-                    printf("<@%d> IDLE: CPU and I/O are idle\n", tbl->clk);
-                    return -1;  // CPU and I/O IDLE: running_p == NULL
-                }
-                // log message: DISPATCH
-                printf("<@%d> DISPATCH: [%d] to CPU\n", tbl->clk, out->pid);
-                tbl->running_p = out;
-                tbl->running_p->state = 2;  // running
-                dequeue(tbl->ready_q, tbl->running_p);
-            }
-            break;
-        case 2: // preemptive SJF
-            out = _SJF(tbl->ready_q);   // NULL if ready_q is empty, else returns a Process
-            if(out != NULL){
-                if(tbl->running_p == NULL){
-                    tbl->running_p = out;
-                    printf("<@%d> DISPATCH: [%d] to CPU\n", tbl->clk, tbl->running_p->pid);
-                    tbl->running_p->state = 2; // running
-                    dequeue(tbl->ready_q, tbl->running_p);
-                }
-                else if(tbl->running_p->cpu_burst_rem > out->cpu_burst_rem){   // preempt running_p with out
-                    printf("<@%d> PREEMPT: DISPATCH [%d] (%d clk) to CPU, [%d] (%d clk) to ready queue\n",
-                           tbl->clk, out->pid, out->cpu_burst_rem, tbl->running_p->pid, tbl->running_p->cpu_burst_rem);
-                    tbl->running_p->state = 1;  // preempt  to ready
-                    enqueue(tbl->ready_q, tbl->running_p);
-                    tbl->running_p = out;
-                    tbl->running_p->state = 2;  // running
-                    dequeue(tbl->ready_q, tbl->running_p);
-                }
-                // else: keep running_p 
-            }
-            // else: if out == NULL --> keep running_p whether NULL or not.
-            break;
-        case 3: // priority w/o preemption
-            if(tbl->running_p == NULL && tbl->io_p == NULL){
-                out = _PRIO(tbl->ready_q, NULL);
-                if(out == NULL){
-                    gannt[tbl->clk] = -1;
-                    // log message: IDLE
-                    printf("<@%d> IDLE: CPU and I/O are idle\n", tbl->clk);
-                    return -1;  // CPU and I/O IDLE: running_p == NULL
-                }
-                // log message: DISPATCH
-                printf("<@%d> DISPATCH: [%d] to CPU (priority: %d)\n", tbl->clk, out->pid, out->priority);
-                tbl->running_p = out;
-                tbl->running_p->state = 2;  // running
-                dequeue(tbl->ready_q, tbl->running_p);
-            }
-            break;
-        case 4: // priority w/ preemption
-            out = _PRIO(tbl->ready_q, tbl->running_p);
-            if(out == NULL){
-                break; // CPU is IDLE
-            }
-            // out != NULL       
-            if(tbl->running_p == NULL){
-                tbl->running_p = out;
-                printf("<@%d> DISPATCH: [%d](p:%d) to CPU\n", tbl->clk, tbl->running_p->pid, tbl->running_p->priority);
-                tbl->running_p->state = 2; // running
-                dequeue(tbl->ready_q, tbl->running_p);
-            }
-            if(out != tbl->running_p){  // Premption: `out` replaces running_p
-                printf("<@%d> PREEMPT: [%d](p: %d) (%d clk) to CPU, [%d](p:%d) (%d clk) to ready queue\n",
-                       tbl->clk, out->pid, out->priority, out->cpu_burst_rem,
-                       tbl->running_p->pid, tbl->running_p->priority ,tbl->running_p->cpu_burst_rem);
-                tbl->running_p->state = 1;  // preempt  to ready queue
-                enqueue(tbl->ready_q, tbl->running_p);
-                tbl->running_p = out;
-                tbl->running_p->state = 2;  // running
-                dequeue(tbl->ready_q, tbl->running_p);  // remove `out` from ready queue
-            }    
-            break;
-        case 5: // Round Robin: identical time quantum, no priority, always preempt, renew quantum if no process in ready queue
-            if(tbl->ready_q->head == NULL){ // empty ready queue
-                if(tbl->running_p == NULL){
-                    gannt[tbl->clk] = -1;
-                    // log message: IDLE
-                    printf("<@%d> IDLE: CPU idle\n", tbl->clk);
-                    return -1;
-                }
-                if(tbl->quantum == 0){
-                    // no other process to replace running_p --> renew quantum for running_p
-                    printf("<@%d> RR-RENEW: [%d] (%d clk) has no other process to replace it.\n", tbl->clk, tbl->running_p->pid, tbl->running_p->cpu_burst_rem);
-                    tbl->quantum = _quantum;    // reset quantum
-                    break;
-                }
-            }
-            if(tbl->running_p == NULL){
-                tbl->running_p = tbl->ready_q->head->p; // first process in ready queue
-                printf("<@%d> DISPATCH: [%d] to CPU\n", tbl->clk, tbl->running_p->pid);
-                tbl->running_p->state = 2; // running
-                dequeue(tbl->ready_q, tbl->running_p);
-                tbl->quantum = _quantum;    // reset quantum
-            }
-            else{   // tbl->running_p is not finished
-                if(tbl->quantum == 0){  // quantum expired
-                    out = tbl->ready_q->head->p;
-                    printf("<@%d> RR-SWITCH: [%d] (%d clk) to CPU, ", tbl->clk, out->pid, out->cpu_burst_rem);
-                    printf("[%d] (%d clk) to ready queue\n", tbl->running_p->pid, tbl->running_p->cpu_burst_rem);
-                    
-                    tbl->running_p->state = 1;  // preempt  to ready queue
-                    enqueue(tbl->ready_q, tbl->running_p);
-                    
-                    tbl->running_p = out;
-                    tbl->running_p->state = 2;  // running
-                    dequeue(tbl->ready_q, tbl->running_p);  // remove `out` from ready queue
-
-                    tbl->quantum = _quantum;    // reset quantum
-                }
+    bool: true if the task set is schedulable. *util and *density are set, and *fail_at is a clk where
+    the demand exceeds the time (-1: utilization, or passed)
+    */
+    double U = 0, dens = 0, slack = 0;
+    long long dmin = LLONG_MAX, dmax = 0, hyper = 1;
+    bool constrained = false;
+    for(int i=0; i<n; i++){
+        Task *t = &tasks[i];
+        double ui = (double)t->wcet/t->period;
+        U += ui;
+        dens += (double)t->wcet/((t->deadline < t->period) ? t->deadline : t->period);
+        slack += (double)(t->period - t->deadline)*ui;
+        dmin = (t->deadline < dmin) ? t->deadline : dmin;
+        dmax = (t->deadline > dmax) ? t->deadline : dmax;
+        constrained = constrained || t->deadline < t->period;
+        if(hyper <= QPA_MAX_HORIZON){
+            long long a = hyper, b = t->period;
+            while(b != 0){
+                long long c = a % b;
+                a = b;
+                b = c;
             }
-            break;
-        default:
-            printf("Error: CPU() algo not implemented\n");
-            exit(1);
+            hyper = hyper/a*t->period;
+        }
+    }
+    *util = U;
+    *density = dens;
+    *fail_at = -1;
+    if(U > 1 + 1e-9){
+        return false;
+    }
+    if(!constrained || dens <= 1){
+        return true;
     }
+    long long L = (hyper < QPA_MAX_HORIZON) ? hyper + dmax : QPA_MAX_HORIZON;
+    if(U < 1 - 1e-9){
+        double la = slack/(1 - U);
+        long long bound = (la > dmax) ? (long long)la + 1 : dmax + 1;
+        L = (bound < L) ? bound : L;
+    }
+    long long t = _last_deadline_before(tasks, n, L);
+    long long h = _task_demand(tasks, n, t);
+    while(h <= t && h > dmin){
+        t = (h < t) ? h : _last_deadline_before(tasks, n, t);
+        h = _task_demand(tasks, n, t);
+    }
+    if(h <= dmin){
+        return true;
+    }
+    *fail_at = t;
+    return false;
+}
 
 
-    if(tbl->running_p == NULL){
-        gannt[tbl->clk] = -1;
-        // log message: CPU IDLE
-        printf("<@%d> IDLE: CPU is idle\n", tbl->clk);
-        return -1;
+static void _reset_process(Process* p){
+    /* state and time related attributes of a process that has not arrived yet */
+    p->state = 0; // new
+
+    // time related attributes are initialised to 0
+    p->ready_wait_time = 0;
+    p->io_wait_time = 0;
+    p->turnaround_time = 0;
+    p->finish_time = 0;
+    p->first_run = -1;
+    p->q_enter_clk = 0;
+
+    p->heap_idx = -1;
+    p->core = -1;
+    p->q_seq = 0;
+    p->level = 0;
+    p->slice = -1;
+    p->epoch = -1;
+    p->vruntime = -1;
+    p->tickets = 0;
+    p->pass = -1;
+    p->ent_mark = 0;
+    p->entitled = 0;
+
+    p->node.p = p;
+    p->node.left = NULL;
+    p->node.right = NULL;
+    p->node.q = NULL;
+}
+
+void rng_seed(Rng* rng, uint64_t seed){
+    /*
+    Seed a xoshiro256** generator. The state is filled with splitmix64 so that any seed (even 0) works
+    */
+    for(int i=0; i<4; i++){
+        seed += 0x9e3779b97f4a7c15ULL;
+        uint64_t z = seed;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        rng->s[i] = z ^ (z >> 31);
     }
+}
 
-    // 2. compute
-    if(algo == 5){tbl->quantum--;}  // if Round Robin 
-    // compute CPU burst
-    tbl->running_p->cpu_burst_rem--;
-    gannt[tbl->clk] = tbl->running_p->pid;
-    // check if running_p is finished
 
-    if(tbl->running_p->cpu_burst_rem == 0){
-        printf("<@%d> TERMINATE: [%d] to term queue \n", tbl->clk, tbl->running_p->pid);
+static inline uint64_t rng_rotl(uint64_t x, int k){
+    return (x << k) | (x >> (64 - k));
+}
+
+
+uint64_t rng_next(Rng* rng){
+    /* next 64 random bits (xoshiro256**) */
+    uint64_t *s = rng->s;
+    uint64_t result = rng_rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rng_rotl(s[3], 45);
+    return result;
+}
+
+
+int rng_below(Rng* rng, int n){
+    /* random int in 0 ~ n-1 (multiply-shift instead of modulo) */
+    return (int)(((rng_next(rng) >> 32) * (uint64_t)n) >> 32);
+}
+
+
+Queue* create_queue(int type){
+    /*
+    Create an empty Queue 
+
+    int type: 0: linked list, 1: heap on cpu_burst_rem (SJF), 2: heap on priority,
+              3: key array on cpu_burst_rem, 4: key array on priority,
+              5: multi-level feedback queue (levels are set up by mlfq_init()), 6: heap on vruntime (CFS),
+              7: heap on absolute deadline (EDF), 8: lottery, 9: heap on pass (stride) (tickets set by ticket_init())
+    */
+    Queue *new_queue = (Queue*)malloc(sizeof(Queue));
+    new_queue->head = NULL;
+    new_queue->tail = NULL;
+    new_queue->cnt = 0;
+    new_queue->type = type;
+    new_queue->cap = (type == 0 || type == 5) ? 0 : 16;
+    new_queue->heap = (new_queue->cap == 0) ? NULL : (Process**)malloc(sizeof(Process*)*new_queue->cap);
+    new_queue->key = (type == 3 || type == 4) ? (int*)malloc(sizeof(int)*new_queue->cap) : NULL;
+    new_queue->kseq = (type == 3 || type == 4) ? (long long*)malloc(sizeof(long long)*new_queue->cap) : NULL;
+    new_queue->seq = 0;
+    new_queue->allocs = 0;
+    new_queue->clk = NULL;
+    new_queue->acct = 0;
+    new_queue->lv = NULL;
+    new_queue->lq = NULL;
+    new_queue->levels = 0;
+    new_queue->bitmap = 0;
+    new_queue->boost = 0;
+    new_queue->epoch = 0;
+    new_queue->min_vruntime = 0;
+    new_queue->credit = 0;
+    new_queue->fen = NULL;
+    new_queue->tickets = 0;
+    new_queue->global_pass = 0;
+    new_queue->prof = false;
+    new_queue->sel_calls = 0;
+    new_queue->sel_timed = 0;
+    new_queue->sel_ns = 0;
+
+    return new_queue;
+}
+
+
+void mlfq_init(Queue* q, Config* cfg){
+    /*
+    Levels of a multi-level feedback queue (type 5): Config.mlfq_levels empty lists,
+    their quanta (Config.mlfq_quanta, unset ones double the quantum of the level above) and the boost period
+    */
+    q->levels = cfg->mlfq_levels;
+    q->lv = (Queue*)calloc(q->levels, sizeof(Queue));   // empty lists, not timed
+    q->lq = (int*)malloc(sizeof(int)*q->levels);
+    for(int i=0; i<q->levels; i++){
+        if(cfg->mlfq_quanta[i] > 0){
+            q->lq[i] = cfg->mlfq_quanta[i];
+        }
+        else{
+            q->lq[i] = (i == 0) ? cfg->quantum : ((q->lq[i-1] < (1<<29)) ? q->lq[i-1]*2 : q->lq[i-1]);
+        }
+    }
+    q->boost = cfg->mlfq_boost;
+}
+
+
+static int _ready_q_type(Config* cfg){
+    /* Queue.type of the ready queue: heap or key array on what the algorithm selects by (if enabled) */
+    int type = _policy_queue(cfg->algo);
+    if(type == 1 || type == 2){
+        // cpu_burst_rem or priority: list (scanned), heap or key array (types 3, 4)
+        return (cfg->ready_q_type == 1) ? type : (cfg->ready_q_type == 2) ? type + 2 : 0;
+    }
+    return type;
+}
+
+
+Queue* create_ready_queue(Config* cfg, long long* clk){
+    /* empty ready queue for cfg->algo, timed with `clk` (wait time goes to Process.ready_wait_time) */
+    Queue *q = create_queue(_ready_q_type(cfg));
+    q->clk = clk;
+    q->acct = 1;
+    q->prof = cfg->profile;
+    if(q->type == 5){
+        mlfq_init(q, cfg);
+    }
+    if(q->type == 8 || q->type == 9){
+        ticket_init(q, cfg);
+    }
+    q->credit = (long long)cfg->cfs_latency / 2 * CFS_WEIGHT_0;
+    return q;
+}
+
+
+Table* create_table(Config *cfg){
+    /*
+    Create a Table which keeps track of all queues, running process, and current time
+
+    Attributes
+    ----------
+    Process** new_pool: array of pointers to processes sorted by arrival time (assigned by create_process() in main())
+
+    int next_arrival: cursor into new_pool, everything before it has arrived
+
+    Queue* ready_q: queue of processes that are ready to be executed
+
+    Queue* term_q: queue of processes that have terminated
+
+    Process* running_p: pointer to process that is currently running
+
+    DeviceSet* io: Config.num_devices I/O devices, each with a wait queue (see create_devices())
+
+    Trace* trace: Config.trace_file replay (see open_trace()), NULL: processes come from create_process()
+
+    int clk: current time
+
+    int quantum: time quantum for Round Robin
+
+    long long allocs: number of allocations made by the simulation loop (see track_allocs())
+
+    EventLog* log: event log (Config.log_level, NULL if logging is off)
+
+    TimelineOut* tl_out: timeline export (Config.timeline_file, NULL if off), shared with the cores
+
+    Timeline gannt: gannt chart of this simulation
+
+    Rng rng: random number generator seeded with Config.seed (used by create_process(), then by the lottery draws)
+
+    Table** cores: multi-core (Config.num_cores > 1): the Tables of the cores (see create_core()),
+                   the Table itself then only holds new_pool, the I/O devices and term_q
+
+    long long migrations: number of processes moved between cores by steal_work()
+    */
+    Table *new_table = (Table*)malloc(sizeof(Table));   
+    new_table->new_pool = NULL; // create_process() will create/allocate new_pool
+    new_table->pool_cnt = 0;
+    new_table->proc_block = NULL;
+    new_table->next_arrival = 0;
+    // time spent in ready_q/wait queues is accounted when a process leaves the queue
+    new_table->ready_q = create_ready_queue(cfg, &new_table->clk);
+    new_table->term_q = create_queue(0);
+    new_table->trace = (cfg->trace_file != NULL) ? open_trace(cfg->trace_file, cfg) : NULL;   // may raise num_devices
+    new_table->io = create_devices((cfg->num_devices > 1) ? cfg->num_devices : 1, &new_table->clk);
+    new_table->io_block = NULL;
+    new_table->running_p = NULL;
+    new_table->clk = 0;
+    new_table->quantum = cfg->quantum;
+    new_table->allocs = 0;
+    new_table->alloc_clk = -1;
+    new_table->log = (cfg->log_level > 0) ? create_event_log(cfg->log_size, cfg->log_level, cfg->verbose, cfg->log_file) : NULL;
+    new_table->tl_out = (cfg->timeline_file != NULL) ?
+        open_timeline(cfg->timeline_file, cfg->timeline_binary, (cfg->num_cores > 1) ? cfg->num_cores : 1, new_table->io->num_devices) : NULL;
+    new_table->gannt.seg = NULL;
+    new_table->gannt.cnt = 0;
+    new_table->gannt.cap = 0;
+    new_table->gannt.tail_only = !cfg->keep_gannt;
+    new_table->gannt.busy = 0;
+    new_table->gannt.out = new_table->tl_out;
+    new_table->gannt.track = 0;
+    rng_seed(&new_table->rng, (uint64_t)cfg->seed);
+    new_table->stats = (Stats*)calloc(1, sizeof(Stats));
+    new_table->num_cores = (cfg->num_cores > 1) ? cfg->num_cores : 1;
+    new_table->core_id = -1;
+    new_table->migrations = 0;
+    new_table->dispatches = 0;
+    new_table->cores = NULL;
+    if(new_table->num_cores > 1){
+        new_table->cores = (Table**)malloc(sizeof(Table*)*new_table->num_cores);
+        for(int i=0; i<new_table->num_cores; i++){
+            new_table->cores[i] = create_core(new_table, cfg, i);
+        }
+    }
+
+    return new_table;
+}
+
+
+Table* create_core(Table* tbl, Config* cfg, int id){
+    /*
+    Create the Table of one simulated core: its own ready_q, running_p, quantum and gannt chart.
+    The I/O devices, term_q and the log are shared with `tbl`
+    */
+    Table *core = (Table*)malloc(sizeof(Table));
+    core->new_pool = NULL;
+    core->pool_cnt = 0;
+    core->proc_block = NULL;
+    core->next_arrival = 0;
+    core->ready_q = create_ready_queue(cfg, &core->clk);
+    core->term_q = tbl->term_q;
+    core->io = tbl->io;
+    core->trace = tbl->trace;
+    core->io_block = NULL;
+    core->running_p = NULL;
+    core->clk = 0;
+    core->quantum = cfg->quantum;
+    core->allocs = 0;
+    core->alloc_clk = -1;
+    core->log = tbl->log;
+    core->tl_out = tbl->tl_out;
+    core->gannt.seg = NULL;
+    core->gannt.cnt = 0;
+    core->gannt.cap = 0;
+    core->gannt.tail_only = !cfg->keep_gannt;
+    core->gannt.busy = 0;
+    core->gannt.out = tbl->tl_out;
+    core->gannt.track = id;
+    rng_seed(&core->rng, (uint64_t)cfg->seed ^ (0x9e3779b9ULL * (id + 1)));  // lottery draws of the core
+    core->stats = tbl->stats;
+    core->cores = NULL;
+    core->num_cores = 1;
+    core->core_id = id;
+    core->migrations = 0;
+    core->dispatches = 0;
+    return core;
+}
+
+static Process* _trace_read(Trace* tr);
+static void _trace_free_slot(Trace* tr, Process* p);
+
+
+Process* peek_arrival(Table* tbl){
+    /*
+    The next process to arrive (NULL if every process has arrived):
+    new_pool[next_arrival], or the next trace record (turned into a Process the first time it is asked for)
+    */
+    Trace *tr = tbl->trace;
+    if(tr == NULL){
+        return (tbl->next_arrival < tbl->pool_cnt) ? tbl->new_pool[tbl->next_arrival] : NULL;
+    }
+    if(tr->next == NULL && tr->read < tr->hdr.count){
+        tr->next = _trace_read(tr);
+    }
+    return tr->next;
+}
+
+
+static void _take_arrival(Table* tbl){
+    /* the process returned by peek_arrival() has arrived */
+    tbl->next_arrival++;
+    if(tbl->trace != NULL){
+        tbl->trace->next = NULL;
+    }
+}
+
+
+void arrived_to_ready(Table* tbl, int count){
+    /*
+    Enqueue the processes that arrive at tbl->clk to ready_q.
+    new_pool (or the trace) is in arrival order, so only the next process to arrive is checked (peek_arrival())
+
+    Parameters
+    ----------
+    int count: maximum length of new_pool (i.e. cfg->num_process)
+    */
+    Queue *ready_q = tbl->ready_q;
+    Process *p;
+
+    while(tbl->next_arrival < count && (p = peek_arrival(tbl)) != NULL && p->arrival_time <= tbl->clk){
+        _take_arrival(tbl);
+        // log message
+        LOG_EVENT(tbl, tbl->clk, LOG_ARRIVE, p->pid, 0, 0, 0, 0, 0);
+        enqueue(ready_q, p);
+        p->state = 1; // ready
+        share_join(tbl->stats, p);
+    }
+}
+
+
+ALWAYS_INLINE void _wait_to_ready(Table* tbl, const int algo){
+    /* if I/O processes are done, move them to ready queue (or assign to CPU if non-preemptive) */
+
+    Process *p;
+    while((p = io_complete(tbl)) != NULL){
+        if(_preemptive(algo) || tbl->running_p != NULL){    // if preemptive, move p to ready queue
+            LOG_EVENT(tbl, tbl->clk-1, LOG_IO_COMPLETE, p->pid, 0, 0, 0, 0, 0);
+            LOG_EVENT(tbl, tbl->clk, LOG_READY, p->pid, 0, 0, 0, 0, 0);
+            p->state = 1;   // ready
+            enqueue(tbl->ready_q, p);
+            share_join(tbl->stats, p);
+        }
+        else{   // if non-preemptive, running_p = p
+            LOG_EVENT(tbl, tbl->clk-1, LOG_IO_COMPLETE_NP, p->pid, 0, 0, 0, 0, 0);
+            LOG_EVENT(tbl, tbl->clk, LOG_DISPATCH_IO, p->pid, 0, 0, 0, 0, 0);
+            p->state = 2;   // running
+            tbl->dispatches++;
+            tbl->running_p = p;
+        }
+    }
+}
+
+
+void wait_to_ready(Table* tbl, int algo){
+    /* _wait_to_ready() for an algo only known at run time */
+    _wait_to_ready(tbl, algo);
+}
+
+
+DeviceSet* create_devices(int num_devices, long long* clk){
+    /*
+    Create `num_devices` idle I/O devices. Time spent in their wait queues is timed with `clk`
+    */
+    DeviceSet *io = (DeviceSet*)malloc(sizeof(DeviceSet));
+    io->num_devices = num_devices;
+    io->dev = (Device*)malloc(sizeof(Device)*num_devices);
+    for(int i=0; i<num_devices; i++){
+        io->dev[i].wait_q = create_queue(0);
+        io->dev[i].wait_q->clk = clk;
+        io->dev[i].wait_q->acct = 2;
+        io->dev[i].io_p = NULL;
+        io->dev[i].done_clk = 0;
+        io->dev[i].busy = 0;
+        io->dev[i].pending = false;
+    }
+    io->done = create_event_queue(16);
+    io->start = (int*)malloc(sizeof(int)*num_devices);
+    io->start_cnt = 0;
+    io->busy = 0;
+    io->completed = 0;
+    return io;
+}
+
+
+void request_io(DeviceSet* io, Process* p){
+    /*
+    Put p in the wait queue of the device of its current I/O burst.
+    An idle device is listed in io->start so that io_service() starts it next clk
+    */
+    Device *d = &io->dev[p->io_dev];
+    enqueue(d->wait_q, p);
+    if(d->io_p == NULL && !d->pending){
+        d->pending = true;
+        io->start[io->start_cnt++] = p->io_dev;
+    }
+    io->busy++;
+}
+
+
+Process* io_complete(Table* tbl){
+    /*
+    Take one process whose I/O burst is over by tbl->clk off its device (NULL if there is none).
+    Its next I/O burst (if any) is loaded, and the device is listed to start the next waiting process
+    */
+    DeviceSet *io = tbl->io;
+    if(io->done->cnt == 0 || io->done->heap[0].time > tbl->clk){
+        return NULL;
+    }
+    Device *d = &io->dev[pop_event(io->done).pid];
+    Process *p = d->io_p;
+    d->io_p = NULL;
+    if(d->wait_q->head != NULL && !d->pending){
+        d->pending = true;
+        io->start[io->start_cnt++] = (int)(d - io->dev);
+    }
+    io->busy--;
+    io->completed++;
+    if(p->io_next < p->io_cnt){
+        IoBurst *b = &p->io_seq[p->io_next++];
+        p->io_burst_start = b->gap;
+        p->io_burst_rem = b->len;
+        p->io_dev = b->dev;
+    }
+    return p;
+}
+
+void retire_process(Table* tbl, Process* p){
+    /*
+    A terminated process is recorded in the metrics (tbl->stats) and goes to term_q.
+    Replayed processes are not kept, their slot is reused
+    */
+    Stats *st = tbl->stats;
+    hist_record(&st->turnaround, p->turnaround_time);
+    hist_record(&st->ready_wait, p->ready_wait_time);
+    hist_record(&st->io_wait, p->io_wait_time);
+    hist_record(&st->response, p->first_run - p->arrival_time);
+    double share = (double)p->cpu_burst_init / (p->cpu_burst_init + p->ready_wait_time);
+    double scaled = share * CFS_WEIGHT_0 / cfs_weight(p->priority);
+    st->share_sum += scaled;
+    st->share_sq += scaled * scaled;
+    if(p->priority >= 1 && p->priority <= MAX_PRIORITY){
+        st->prio_cnt[p->priority-1]++;
+        st->prio_share[p->priority-1] += share;
+    }
+    share_leave(st, p);
+    if(p->tickets > 0 && p->entitled > 0){
+        double dev = p->cpu_burst_init / p->entitled - 1.0;
+        hist_record(&st->share_dev, (long long)(((dev < 0) ? -dev : dev)*1000 + 0.5));
+    }
+    if(p->deadline > 0){
+        // it had the clks arrival_time ~ arrival_time + deadline - 1 to finish in
+        long long lateness = p->finish_time + 1 - (p->arrival_time + p->deadline);
+        st->deadline_jobs++;
+        st->lateness_sum += lateness;
+        if(lateness > 0){
+            hist_record(&st->lateness, lateness);
+            LOG_EVENT(tbl, tbl->clk, LOG_DEADLINE_MISS, p->pid, 0, 0, 0, 0, lateness);
+        }
+    }
+    if(tbl->trace == NULL){
+        enqueue(tbl->term_q, p);
+        return;
+    }
+    _trace_free_slot(tbl->trace, p);
+}
+
+
+long long terminated(Table* tbl){
+    /* number of terminated processes */
+    return tbl->stats->turnaround.n;
+}
+
+
+void hist_record(Histogram* h, long long v){
+    /*
+    Add v (negative counts as 0) to the histogram.
+    Bucket: v itself below 2^(HIST_SUB_BITS+1), otherwise the top HIST_SUB_BITS+1 bits of v and their shift
+    */
+    v = (v < 0) ? 0 : v;
+    int shift = 0;
+#ifdef __GNUC__
+    shift = 63 - __builtin_clzll((unsigned long long)v | 1) - HIST_SUB_BITS;
+    shift = (shift < 0) ? 0 : shift;
+#else
+    while((v >> shift) >= (2 << HIST_SUB_BITS)){
+        shift++;
+    }
+#endif
+    h->cnt[(shift << HIST_SUB_BITS) + (int)(v >> shift)]++;
+    h->n++;
+    h->sum += v;
+    h->max = (v > h->max) ? v : h->max;
+}
+
+
+long long hist_percentile(Histogram* h, double q){
+    /* smallest bucket upper bound that covers the q (0~1) quantile (at most the recorded max) */
+    long long rank = (long long)(q*h->n);
+    rank = (rank < h->n) ? rank + (q*h->n > rank) : h->n;   // ceil
+    rank = (rank < 1) ? 1 : rank;
+    long long seen = 0;
+    for(int i=0; i<HIST_BUCKETS && h->n > 0; i++){
+        seen += h->cnt[i];
+        if(seen >= rank){
+            int shift = (i >> HIST_SUB_BITS) - 1;
+            shift = (shift < 0) ? 0 : shift;
+            long long hi = ((long long)(i - (shift << HIST_SUB_BITS)) << shift) + (1LL << shift) - 1;
+            return (hi < h->max) ? hi : h->max;
+        }
+    }
+    return 0;
+}
+
+
+void hist_dist(Histogram* h, Dist* d){
+    d->p50 = hist_percentile(h, 0.50);
+    d->p95 = hist_percentile(h, 0.95);
+    d->p99 = hist_percentile(h, 0.99);
+    d->max = h->max;
+}
+
+
+static int _core_load(Table* core){
+    /* processes a core has to run: ready + running */
+    return core->ready_q->cnt + (core->running_p != NULL);
+}
+
+
+void arrived_to_cores(Table* tbl, int count){
+    /*
+    Multi-core version of arrived_to_ready(): each process that arrives at tbl->clk
+    goes to the ready queue of the least loaded core (lowest index on ties)
+    */
+    Process *p;
+    while(tbl->next_arrival < count && (p = peek_arrival(tbl)) != NULL && p->arrival_time <= tbl->clk){
+        _take_arrival(tbl);
+        Table *core = tbl->cores[0];
+        for(int i=1; i<tbl->num_cores; i++){
+            if(_core_load(tbl->cores[i]) < _core_load(core)){
+                core = tbl->cores[i];
+            }
+        }
+        LOG_EVENT(core, tbl->clk, LOG_ARRIVE, p->pid, 0, 0, 0, 0, 0);
+        p->core = core->core_id;
+        enqueue(core->ready_q, p);
+        p->state = 1; // ready
+        share_join(tbl->stats, p);
+    }
+}
+
+
+void io_to_core(Table* tbl){
+    /*
+    Multi-core version of wait_to_ready(): a process that finished I/O goes back to the ready queue
+    of its core, for every algorithm (with several cores the CPU does not hold itself for the I/O devices,
+    so there is no non-preemptive hand-off from I/O straight to the CPU)
+    */
+    Process *p;
+    while((p = io_complete(tbl)) != NULL){
+        Table *core = tbl->cores[p->core];
+        LOG_EVENT(tbl, tbl->clk-1, LOG_IO_COMPLETE, p->pid, 0, 0, 0, 0, 0);
+        LOG_EVENT(core, tbl->clk, LOG_READY, p->pid, 0, 0, 0, 0, 0);
+        p->state = 1;   // ready
+        enqueue(core->ready_q, p);
+        share_join(tbl->stats, p);
+    }
+}
+
+
+bool steal_work(Table* tbl, Table* core, int algo){
+    /*
+    Work stealing: if `core` has nothing to run, take the process the busiest core would run next.
+    A core is only robbed if it keeps something to run (load >= 2). Returns true if a process moved
+    */
+    if(_core_load(core) != 0){
+        return false;
+    }
+    Table *victim = NULL;
+    for(int i=0; i<tbl->num_cores; i++){
+        Table *c = tbl->cores[i];
+        if(c != core && _core_load(c) >= 2 && c->ready_q->cnt > 0 &&
+           (victim == NULL || _core_load(c) > _core_load(victim))){
+            victim = c;
+        }
+    }
+    if(victim == NULL){
+        return false;
+    }
+    Process *p;
+    switch(_policy_queue(algo)){
+        case 1:
+            p = _SJF(victim->ready_q);
+            break;
+        case 2:
+            p = _PRIO(victim->ready_q, NULL);
+            break;
+        case 5:
+            p = _MLFQ(victim->ready_q);
+            break;
+        case 6:
+        case 7:
+        case 9:
+            p = _TOP(victim->ready_q);
+            break;
+        case 8:
+            p = victim->ready_q->heap[victim->ready_q->cnt - 1];   // any ticket holder, the last one is the cheapest to move
+            break;
+        default:
+            p = victim->ready_q->head->p;
+    }
+    LOG_EVENT(core, tbl->clk, LOG_MIGRATE, p->pid, 0, victim->core_id, core->core_id, 0, 0);
+    dequeue(victim->ready_q, p);
+    enqueue(core->ready_q, p);
+    p->core = core->core_id;
+    tbl->migrations++;
+    return true;
+}
+
+
+void enqueue(Queue *q, Process *p){
+    /*
+    Link the process' own Node to the tail of the queue (no allocation)
+    (heap queues: insert p into the heap instead, key array queues: append p to the arrays,
+    multi-level queues: link it to the list of its level, vruntime heap: place p (cfs_place()) and insert it)
+    */
+    if(q->clk != NULL){
+        p->q_enter_clk = *q->clk;
+    }
+    if(q->type == 1 || q->type == 2 || q->type == 7){
+        heap_push(q, p);
+        return;
+    }
+    if(q->type == 6){
+        cfs_place(q, p);
+        heap_push(q, p);
+        return;
+    }
+    if(q->type == 3 || q->type == 4){
+        array_push(q, p);
+        return;
+    }
+    if(q->type == 5){
+        mlfq_push(q, p);
+        return;
+    }
+    if(q->type == 8){
+        lottery_push(q, p);
+        return;
+    }
+    if(q->type == 9){
+        stride_place(q, p);
+        heap_push(q, p);
+        return;
+    }
+
+    Node *new_node = &p->node;
+    if(new_node->q != NULL){
+        printf("Error: enqueue() process [%d] is already in a queue\n", p->pid);
+        exit(1);
+    }
+    new_node->q = q;
+
+    if(q->head == NULL){
+        q->head = new_node;
+        q->tail = new_node;
+        new_node->left = NULL;
+        new_node->right = NULL;
+    } // queue is empty
+    else{
+        q->tail->right = new_node;
+        new_node->left = q->tail;
+        new_node->right = NULL;
+        q->tail = new_node;
+    } // queue is not empty
+    q->cnt++;
+
+}
+
+
+void dequeue(Queue* q, Process* p){
+    /*
+    Unlink the process' Node from the queue: O(1), nothing is freed
+    Time spent in the queue is added to the process' wait time here
+    (a process that enters at clk=t and leaves at clk=t' waited during t ~ t'-1)
+    */
+    if(q->acct == 1){
+        p->ready_wait_time += *q->clk - p->q_enter_clk;
+    }
+    else if(q->acct == 2){
+        p->io_wait_time += *q->clk - p->q_enter_clk;
+    }
+    if(q->type == 1 || q->type == 2 || q->type == 6 || q->type == 7 || q->type == 9){
+        heap_remove(q, p);
+        return;
+    }
+    if(q->type == 3 || q->type == 4){
+        array_remove(q, p);
+        return;
+    }
+    if(q->type == 5){
+        mlfq_remove(q, p);
+        return;
+    }
+    if(q->type == 8){
+        lottery_remove(q, p);
+        return;
+    }
+    Node* curr = &p->node;
+    // check if the process is in this queue
+    if(curr->q != q){
+        printf("Error: dequeue() couldn't find the process to dequeue\n");
+        exit(1);
+    }
+
+    if(curr->left == NULL){ // curr is head
+        q->head = curr->right;
+    }
+    else{
+        curr->left->right = curr->right;
+    }
+    if(curr->right == NULL){ // curr is tail
+        q->tail = curr->left;
+    }
+    else{
+        curr->right->left = curr->left;
+    }
+    curr->left = NULL;
+    curr->right = NULL;
+    curr->q = NULL;
+    q->cnt--;
+}
+
+
+static inline long long _abs_deadline(Process* p){
+    /* clk a process is due (EDF key), LLONG_MAX if it has no deadline */
+    return (p->deadline > 0) ? p->arrival_time + p->deadline : LLONG_MAX;
+}
+
+
+static bool _heap_less(Queue* q, Process* a, Process* b){
+    /* true if `a` must be selected before `b`. Ties go to the process that was enqueued first */
+    if(q->type == 1){
+        if(a->cpu_burst_rem != b->cpu_burst_rem){
+            return a->cpu_burst_rem < b->cpu_burst_rem;
+        }
+    }
+    else if(q->type == 6){
+        if(a->vruntime != b->vruntime){
+            return a->vruntime < b->vruntime;
+        }
+    }
+    else if(q->type == 7){
+        long long da = _abs_deadline(a), db = _abs_deadline(b);
+        if(da != db){
+            return da < db;
+        }
+    }
+    else if(q->type == 9){
+        if(a->pass != b->pass){
+            return a->pass < b->pass;
+        }
+    }
+    else{
+        if(a->priority != b->priority){
+            return a->priority > b->priority;   // larger value is selected first (same as _PRIO())
+        }
+    }
+    return a->q_seq < b->q_seq;
+}
+
+
+static void _heap_set(Queue* q, int i, Process* p){
+    q->heap[i] = p;
+    p->heap_idx = i;
+}
+
+
+static void _heap_up(Queue* q, int i){
+    Process* p = q->heap[i];
+    while(i > 0){
+        int parent = (i-1)/2;
+        if(!_heap_less(q, p, q->heap[parent])){
+            break;
+        }
+        _heap_set(q, i, q->heap[parent]);
+        i = parent;
+    }
+    _heap_set(q, i, p);
+}
+
+
+static void _heap_down(Queue* q, int i){
+    Process* p = q->heap[i];
+    while(1){
+        int child = 2*i + 1;
+        if(child >= q->cnt){
+            break;
+        }
+        if(child+1 < q->cnt && _heap_less(q, q->heap[child+1], q->heap[child])){
+            child++;
+        }
+        if(!_heap_less(q, q->heap[child], p)){
+            break;
+        }
+        _heap_set(q, i, q->heap[child]);
+        i = child;
+    }
+    _heap_set(q, i, p);
+}
+
+
+void heap_push(Queue* q, Process* p){
+    /*
+    Insert a process into a heap queue: O(log n)
+    */
+    if(q->cnt == q->cap){
+        q->cap *= 2;
+        q->heap = (Process**)realloc(q->heap, sizeof(Process*)*q->cap);
+        q->allocs++;
+    }
+    p->q_seq = q->seq++;
+    q->heap[q->cnt] = p;
+    _heap_up(q, q->cnt++);
+}
+
+
+void heap_remove(Queue* q, Process* p){
+    /*
+    Remove a process from a heap queue using its stored index: O(log n)
+    */
+    int i = p->heap_idx;
+    if(i < 0 || i >= q->cnt || q->heap[i] != p){
+        printf("Error: heap_remove() couldn't find the process to dequeue\n");
+        exit(1);
+    }
+    p->heap_idx = -1;
+    q->cnt--;
+    if(i == q->cnt){
+        return; // removed the last element
+    }
+    Process* last = q->heap[q->cnt];   // fill the hole with the last element and restore heap order
+    _heap_set(q, i, last);
+    _heap_up(q, i);
+    _heap_down(q, last->heap_idx);
+}
+
+
+void array_push(Queue* q, Process* p){
+    /*
+    Append a process to a key array queue: O(1)
+    The selection key is stored next to the other keys so _SJF()/_PRIO() scan contiguous memory
+    */
+    if(q->cnt == q->cap){
+        q->cap *= 2;
+        q->heap = (Process**)realloc(q->heap, sizeof(Process*)*q->cap);
+        q->key = (int*)realloc(q->key, sizeof(int)*q->cap);
+        q->kseq = (long long*)realloc(q->kseq, sizeof(long long)*q->cap);
+        q->allocs++;
+    }
+    p->q_seq = q->seq++;
+    p->heap_idx = q->cnt;
+    q->heap[q->cnt] = p;
+    q->key[q->cnt] = (q->type == 3) ? p->cpu_burst_rem : -p->priority;
+    q->kseq[q->cnt] = p->q_seq;
+    q->cnt++;
+}
+
+
+void array_remove(Queue* q, Process* p){
+    /*
+    Remove a process from a key array queue by moving the last entry into its slot: O(1)
+    (enqueue order is kept in kseq, so the order of the array does not matter)
+    */
+    int i = p->heap_idx;
+    if(i < 0 || i >= q->cnt || q->heap[i] != p){
+        printf("Error: array_remove() couldn't find the process to dequeue\n");
+        exit(1);
+    }
+    p->heap_idx = -1;
+    q->cnt--;
+    if(i != q->cnt){
+        q->heap[i] = q->heap[q->cnt];
+        q->key[i] = q->key[q->cnt];
+        q->kseq[i] = q->kseq[q->cnt];
+        q->heap[i]->heap_idx = i;
+    }
+}
+
+
+static inline int _first_set(uint64_t bits){
+    /* index of the lowest set bit of bits != 0 (one instruction with gcc/clang) */
+#if defined(__GNUC__)
+    return __builtin_ctzll(bits);
+#else
+    int i = 0;
+    while(!(bits & 1)){
+        bits >>= 1;
+        i++;
+    }
+    return i;
+#endif
+}
+
+
+static inline long long _mlfq_epoch(Queue* q){
+    /* priority boosts that are due at *q->clk */
+    return (q->boost > 0) ? *q->clk / q->boost : 0;
+}
+
+
+static inline int _mlfq_level(Queue* q, Process* p){
+    /* level of a process in a multi-level queue (processes from before the last boost are in lv[0]) */
+    return (p->epoch < q->epoch) ? 0 : p->level;
+}
+
+
+static void _mlfq_boost(Queue* q){
+    /*
+    Priority boost, done lazily by the first queue operation after it is due:
+    lv[1] ~ lv[levels-1] are appended to lv[0] in level order: O(levels), the processes are not touched
+    (their epoch is now older than q->epoch, _mlfq_level() reads 0 for them)
+    */
+    long long e = _mlfq_epoch(q);
+    if(e <= q->epoch){
+        return;
+    }
+    q->epoch = e;
+    Queue *top = &q->lv[0];
+    uint64_t bits = q->bitmap & ~(uint64_t)1;
+    while(bits != 0){
+        Queue *l = &q->lv[_first_set(bits)];
+        bits &= bits - 1;
+        if(top->head == NULL){
+            top->head = l->head;
+        }
+        else{
+            top->tail->right = l->head;
+            l->head->left = top->tail;
+        }
+        top->tail = l->tail;
+        top->cnt += l->cnt;
+        l->head = NULL;
+        l->tail = NULL;
+        l->cnt = 0;
+    }
+    q->bitmap = (top->cnt > 0) ? 1 : 0;
+}
+
+
+void mlfq_push(Queue* q, Process* p){
+    /*
+    Append a process to the list of its level: O(1)
+    A process whose level was set before the last boost starts over at level 0 with a whole quantum
+    */
+    _mlfq_boost(q);
+    if(p->epoch < q->epoch){
+        p->level = 0;
+        p->slice = -1;
+        p->epoch = q->epoch;
+    }
+    enqueue(&q->lv[p->level], p);
+    p->node.q = q;
+    q->bitmap |= (uint64_t)1 << p->level;
+    q->cnt++;
+}
+
+
+void mlfq_remove(Queue* q, Process* p){
+    /* Unlink a process from the list of its level: O(1) */
+    if(p->node.q != q){
+        printf("Error: mlfq_remove() couldn't find the process to dequeue\n");
+        exit(1);
+    }
+    int lvl = _mlfq_level(q, p);
+    if(p->epoch < q->epoch){    // boosted while it was queued
+        p->level = 0;
+        p->slice = -1;
+    }
+    p->epoch = q->epoch;
+    p->node.q = &q->lv[lvl];
+    dequeue(&q->lv[lvl], p);
+    if(q->lv[lvl].cnt == 0){
+        q->bitmap &= ~((uint64_t)1 << lvl);
+    }
+    q->cnt--;
+}
+
+
+int mlfq_top(Queue* q){
+    /* highest non-empty level of a multi-level queue (-1 if empty): find first set bit of the bitmap, O(1) */
+    _mlfq_boost(q);
+    return (q->bitmap == 0) ? -1 : _first_set(q->bitmap);
+}
+
+
+// CFS weight of priorities 1 ~ MAX_PRIORITY: the Linux weights of nice 5, 0, -5 and -10
+// (a larger value is served first by _PRIO(), so it weighs more)
+static const int _cfs_weights[MAX_PRIORITY] = {335, CFS_WEIGHT_0, 3121, 9548};
+
+
+int cfs_weight(int priority){
+    /* CFS weight of a priority (DEFAULT_PRIORITY, i.e. priorities not used: nice 0) */
+    if(priority < 1){
+        return CFS_WEIGHT_0;
+    }
+    return _cfs_weights[(priority > MAX_PRIORITY) ? MAX_PRIORITY-1 : priority-1];
+}
+
+
+static inline long long _cfs_delta(Process* p){
+    /* vruntime added per clk on the CPU: CFS_WEIGHT_0 at nice 0, less for heavier processes */
+    return CFS_WEIGHT_0 * CFS_WEIGHT_0 / cfs_weight(p->priority);
+}
+
+
+void cfs_place(Queue* q, Process* p){
+    /*
+    vruntime of a process entering a vruntime heap: a new process starts at min_vruntime,
+    one that slept (I/O, another core) gets at most q->credit of it back, so it cannot hold the CPU for long
+    */
+    if(p->vruntime < 0){
+        p->vruntime = q->min_vruntime;
+    }
+    else if(p->vruntime < q->min_vruntime - q->credit){
+        p->vruntime = q->min_vruntime - q->credit;
+    }
+}
+
+
+static void _cfs_update_min(Table* tbl){
+    /* advance min_vruntime of the ready queue to the smallest vruntime of running_p and the leftmost process */
+    Queue *q = tbl->ready_q;
+    long long v = tbl->running_p->vruntime;
+    if(q->cnt > 0 && q->heap[0]->vruntime < v){
+        v = q->heap[0]->vruntime;
+    }
+    if(v > q->min_vruntime){
+        q->min_vruntime = v;
+    }
+}
+
+
+// proportional share (lottery, stride)
+#define STRIDE1 (1LL << 20)     // stride of one ticket
+#define TICKET_SHIFT 40         // fixed point of Stats.ticket_clock
+
+
+void ticket_init(Queue* q, Config* cfg){
+    /*
+    Tickets of each priority for a lottery (type 8) or stride (type 9) queue: Config.tickets,
+    by default the CFS weight of the priority, so the shares are the ones CFS aims for.
+    A lottery queue also gets its Fenwick tree (same capacity as the process array)
+    */
+    q->tickets_of[0] = cfs_weight(DEFAULT_PRIORITY);
+    for(int i=1; i<=MAX_PRIORITY; i++){
+        q->tickets_of[i] = (cfg->tickets[i-1] > 0) ? cfg->tickets[i-1] : cfs_weight(i);
+    }
+    if(q->type == 8){
+        q->fen = (long long*)calloc(q->cap + 1, sizeof(long long));
+    }
+}
+
+
+static inline int _tickets_of(Queue* q, Process* p){
+    return q->tickets_of[(p->priority < 1 || p->priority > MAX_PRIORITY) ? 0 : p->priority];
+}
+
+
+static void _fen_add(Queue* q, int i, long long v){
+    /* add v to the tickets of heap[i] */
+    for(i++; i<=q->cap; i += i & -i){
+        q->fen[i] += v;
+    }
+}
+
+
+static void _fen_build(Queue* q){
+    /* (re)build the Fenwick tree over heap[0 ~ cnt-1] in O(n); partial sums are carried up to q->cap */
+    q->fen = (long long*)realloc(q->fen, sizeof(long long)*(q->cap + 1));
+    memset(q->fen, 0, sizeof(long long)*(q->cap + 1));
+    for(int i=1; i<=q->cap; i++){
+        if(i <= q->cnt){
+            q->fen[i] += q->heap[i-1]->tickets;
+        }
+        int j = i + (i & -i);
+        if(j <= q->cap){
+            q->fen[j] += q->fen[i];
+        }
+    }
+}
+
+
+void lottery_push(Queue* q, Process* p){
+    /*
+    Append a process to a lottery queue and add its tickets to the Fenwick tree: O(log n).
+    The tree is rebuilt in O(n) when the array grows (the capacity stays a power of two for the draw)
+    */
+    if(q->cnt == q->cap){
+        q->cap *= 2;
+        q->heap = (Process**)realloc(q->heap, sizeof(Process*)*q->cap);
+        _fen_build(q);
+        q->allocs++;
+    }
+    p->tickets = _tickets_of(q, p);
+    p->q_seq = q->seq++;
+    p->heap_idx = q->cnt;
+    q->heap[q->cnt] = p;
+    _fen_add(q, q->cnt++, p->tickets);
+    q->tickets += p->tickets;
+}
+
+
+void lottery_remove(Queue* q, Process* p){
+    /* Remove a process from a lottery queue, the last one takes its slot: O(log n) */
+    int i = p->heap_idx;
+    if(i < 0 || i >= q->cnt || q->heap[i] != p){
+        printf("Error: lottery_remove() couldn't find the process to dequeue\n");
+        exit(1);
+    }
+    int last = --q->cnt;
+    _fen_add(q, i, -p->tickets);
+    q->tickets -= p->tickets;
+    if(i != last){
+        Process *moved = q->heap[last];
+        _fen_add(q, last, -moved->tickets);
+        _fen_add(q, i, moved->tickets);
+        q->heap[i] = moved;
+        moved->heap_idx = i;
+    }
+    p->heap_idx = -1;
+}
+
+
+static Process* _lottery_draw(Queue* q, Rng* rng, long long* ticket){
+    /* the holder of a random ticket: descend the Fenwick tree, O(log n) */
+    long long r = (long long)(rng_next(rng) % (uint64_t)q->tickets);
+    *ticket = r;
+    int pos = 0;
+    for(int step = q->cap; step > 0; step >>= 1){
+        if(pos + step <= q->cnt && q->fen[pos + step] <= r){
+            pos += step;
+            r -= q->fen[pos];
+        }
+    }
+    return q->heap[pos];
+}
+
+
+void stride_place(Queue* q, Process* p){
+    /*
+    pass of a process entering a stride heap: a new process starts at global_pass, one that left
+    (I/O, another core) is moved up to global_pass, so time away does not turn into a claim on the CPU
+    */
+    p->tickets = _tickets_of(q, p);
+    if(p->pass < q->global_pass){
+        p->pass = q->global_pass;
+    }
+}
+
+
+static inline long long _stride(Process* p){
+    /* pass added per clk on the CPU */
+    return STRIDE1 / p->tickets;
+}
+
+
+static void _stride_update_global(Table* tbl){
+    /* advance global_pass to the smallest pass of running_p and the top of the heap */
+    Queue *q = tbl->ready_q;
+    long long v = tbl->running_p->pass;
+    if(q->cnt > 0 && q->heap[0]->pass < v){
+        v = q->heap[0]->pass;
+    }
+    if(v > q->global_pass){
+        q->global_pass = v;
+    }
+}
+
+
+void share_join(Stats* st, Process* p){
+    /* p became runnable (arrived, or back from I/O): it is entitled to a share of the CPU from now on */
+    if(p->tickets > 0){
+        p->ent_mark = st->ticket_clock;
+        st->ticket_total += p->tickets;
+        st->ticket_procs++;
+    }
+}
+
+
+void share_leave(Stats* st, Process* p){
+    /* p stopped being runnable (I/O, terminated) after this clk: add up what it was entitled to */
+    if(p->tickets > 0){
+        p->entitled += p->tickets * (double)(st->ticket_clock - p->ent_mark) / (1LL << TICKET_SHIFT);
+        st->ticket_total -= p->tickets;
+        st->ticket_procs--;
+    }
+}
+
+
+void share_clock(Stats* st, int cores, long long ticks){
+    /*
+    `ticks` clks in which the runnable processes did not change: every ticket is entitled to
+    min(cores, runnable processes) / ticket_total CPU clks per clk. Called before CPU() of the clk,
+    so processes that leave in it (share_leave()) get it too
+    */
+    if(st->ticket_total > 0){
+        long long cpus = (cores < st->ticket_procs) ? cores : st->ticket_procs;
+        st->ticket_clock += ticks * ((cpus << TICKET_SHIFT) / st->ticket_total);
+    }
+}
+
+
+static int _argmin_ties(const int* key, const long long* kseq, int n, int min, int from){
+    /* index of the smallest kseq among key[i] == min, i >= from */
+    int best = -1;
+    for(int i=from; i<n; i++){
+        if(key[i] == min && (best < 0 || kseq[i] < kseq[best])){
+            best = i;
+        }
+    }
+    return best;
+}
+
+
+#ifdef USE_X86_SIMD
+__attribute__((target("avx2")))
+static int _argmin_avx2(const int* key, const long long* kseq, int n){
+    // pass 1: minimum key, 8 lanes at a time
+    __m256i vmin = _mm256_set1_epi32(0x7fffffff);
+    int i = 0;
+    for(; i+8 <= n; i+=8){
+        vmin = _mm256_min_epi32(vmin, _mm256_loadu_si256((const __m256i*)(key+i)));
+    }
+    __m128i m = _mm_min_epi32(_mm256_castsi256_si128(vmin), _mm256_extracti128_si256(vmin, 1));
+    m = _mm_min_epi32(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(1, 0, 3, 2)));
+    m = _mm_min_epi32(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(2, 3, 0, 1)));
+    int min = _mm_cvtsi128_si32(m);
+    for(int j=i; j<n; j++){
+        if(key[j] < min){min = key[j];}
+    }
+    // pass 2: among the lanes equal to min, the earliest enqueued wins
+    __m256i vm = _mm256_set1_epi32(min);
+    int best = -1;
+    for(i=0; i+8 <= n; i+=8){
+        int mask = _mm256_movemask_ps(_mm256_castsi256_ps(
+                   _mm256_cmpeq_epi32(vm, _mm256_loadu_si256((const __m256i*)(key+i)))));
+        while(mask){
+            int j = i + __builtin_ctz(mask);
+            if(best < 0 || kseq[j] < kseq[best]){best = j;}
+            mask &= mask - 1;
+        }
+    }
+    int tail = _argmin_ties(key, kseq, n, min, i);
+    if(tail >= 0 && (best < 0 || kseq[tail] < kseq[best])){best = tail;}
+    return best;
+}
+
+
+__attribute__((target("sse4.1")))
+static int _argmin_sse41(const int* key, const long long* kseq, int n){
+    __m128i vmin = _mm_set1_epi32(0x7fffffff);
+    int i = 0;
+    for(; i+4 <= n; i+=4){
+        vmin = _mm_min_epi32(vmin, _mm_loadu_si128((const __m128i*)(key+i)));
+    }
+    vmin = _mm_min_epi32(vmin, _mm_shuffle_epi32(vmin, _MM_SHUFFLE(1, 0, 3, 2)));
+    vmin = _mm_min_epi32(vmin, _mm_shuffle_epi32(vmin, _MM_SHUFFLE(2, 3, 0, 1)));
+    int min = _mm_cvtsi128_si32(vmin);
+    for(int j=i; j<n; j++){
+        if(key[j] < min){min = key[j];}
+    }
+    __m128i vm = _mm_set1_epi32(min);
+    int best = -1;
+    for(i=0; i+4 <= n; i+=4){
+        int mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(vm, _mm_loadu_si128((const __m128i*)(key+i)))));
+        while(mask){
+            int j = i + __builtin_ctz(mask);
+            if(best < 0 || kseq[j] < kseq[best]){best = j;}
+            mask &= mask - 1;
+        }
+    }
+    int tail = _argmin_ties(key, kseq, n, min, i);
+    if(tail >= 0 && (best < 0 || kseq[tail] < kseq[best])){best = tail;}
+    return best;
+}
+#endif
+
+
+int argmin_key(const int* key, const long long* kseq, int n){
+    /*
+    Index of the smallest key (ties: smallest kseq, i.e. enqueued first), -1 if n == 0.
+    AVX2 or SSE4.1 if the CPU has it (checked at runtime), otherwise scalar
+    */
+    if(n <= 0){
+        return -1;
+    }
+#ifdef USE_X86_SIMD
+    if(__builtin_cpu_supports("avx2")){
+        return _argmin_avx2(key, kseq, n);
+    }
+    if(__builtin_cpu_supports("sse4.1")){
+        return _argmin_sse41(key, kseq, n);
+    }
+#endif
+    int min = key[0];
+    for(int i=1; i<n; i++){
+        if(key[i] < min){min = key[i];}
+    }
+    return _argmin_ties(key, kseq, n, min, 0);
+}
+
+
+void track_allocs(Table* tbl, EventQueue* eq){
+    /*
+    Count the allocations made by the simulation loop so far (queue/event heaps growing)
+    and remember the clk of the latest one. Nodes are embedded in Process,
+    so once the heaps have grown to their working size this stops changing.
+    */
+    long long n = tbl->ready_q->allocs + tbl->term_q->allocs + tbl->io->done->allocs;   // wait queues are lists
+    for(int i=0; tbl->cores != NULL && i<tbl->num_cores; i++){
+        n += tbl->cores[i]->ready_q->allocs;
+    }
+    if(eq != NULL){
+        n += eq->allocs;
+    }
+    if(n != tbl->allocs){
+        tbl->allocs = n;
+        tbl->alloc_clk = tbl->clk;
+    }
+}
+
+
+EventLog* create_event_log(int cap, int level, bool echo, const char* path){
+    /*
+    Create an EventLog with a preallocated ring buffer of `cap` records.
+    If `path` is given, records are written there in binary (see print_log_file())
+    */
+    EventLog *log = (EventLog*)malloc(sizeof(EventLog));
+    log->cap = (cap > 0) ? cap : 4096;
+    log->buf = (LogRec*)malloc(sizeof(LogRec)*log->cap);
+    log->level = level;
+    log->echo = echo;
+    log->total = 0;
+    log->flushed = 0;
+    log->sink = NULL;
+    if(path != NULL){
+        log->sink = fopen(path, "wb");
+        if(log->sink == NULL){
+            printf("Error: create_event_log() couldn't open %s\n", path);
+            exit(1);
+        }
+        // header: magic, version, record size
+        int header[3] = {0x474c5343, 2, (int)sizeof(LogRec)};  // "CSLG"
+        fwrite(header, sizeof(int), 3, log->sink);
+    }
+    return log;
+}
+
+
+void log_event(EventLog* log, long long clk, int core, int type, int pid, int pid2, int a0, int a1, int a2, long long arg){
+    /*
+    Store one record in the ring buffer (no formatting unless log->echo)
+    */
+    if(log->sink != NULL && log->total - log->flushed == log->cap){
+        flush_event_log(log);   // buffer full: write it out before overwriting
+    }
+    LogRec *r = &log->buf[log->total % log->cap];
+    r->clk = clk;
+    r->arg = arg;
+    r->type = type;
+    r->core = core;
+    r->pid = pid;
+    r->pid2 = pid2;
+    r->aux[0] = a0;
+    r->aux[1] = a1;
+    r->aux[2] = a2;
+    log->total++;
+    if(log->echo){
+        print_log_rec(stdout, r);
+    }
+}
+
+
+void flush_event_log(EventLog* log){
+    /*
+    Write the records that are not in the sink yet (in order, the ring may wrap around)
+    */
+    if(log->sink == NULL){
+        return;
+    }
+    while(log->flushed < log->total){
+        int start = log->flushed % log->cap;
+        long long n = log->total - log->flushed;
+        if(n > log->cap - start){
+            n = log->cap - start;
+        }
+        fwrite(&log->buf[start], sizeof(LogRec), n, log->sink);
+        log->flushed += n;
+    }
+}
+
+
+void close_event_log(EventLog* log){
+    flush_event_log(log);
+    if(log->sink != NULL){
+        fclose(log->sink);
+    }
+    free(log->buf);
+    free(log);
+}
+
+
+void print_log_rec(FILE* out, LogRec* r){
+    /*
+    Render a LogRec as the text log line
+    */
+    if(r->core >= 0){
+        fprintf(out, "(core %d) ", r->core);
+    }
+    switch(r->type){
+        case LOG_ARRIVE:
+            fprintf(out, "<@%lld> ARRIVE: [%d] arrived to ready queue\n", r->clk, r->pid);
+            break;
+        case LOG_IO_COMPLETE:
+            fprintf(out, "<@%lld> I/O COMPLETE: [%d]\n", r->clk, r->pid);
+            break;
+        case LOG_IO_COMPLETE_NP:
+            fprintf(out, "<@%lld> I/O Complete: [%d]\n", r->clk, r->pid);
+            break;
+        case LOG_READY:
+            fprintf(out, "<@%lld> READY: [%d] to ready queue\n", r->clk, r->pid);
+            break;
+        case LOG_DISPATCH:
+            fprintf(out, "<@%lld> DISPATCH: [%d] to CPU\n", r->clk, r->pid);
+            break;
+        case LOG_DISPATCH_IO:
+            fprintf(out, "<@%lld> DISPATCH: [%d] to CPU from I/O\n", r->clk, r->pid);
+            break;
+        case LOG_DISPATCH_PRIO:
+            fprintf(out, "<@%lld> DISPATCH: [%d] to CPU (priority: %d)\n", r->clk, r->pid, r->aux[0]);
+            break;
+        case LOG_DISPATCH_PPRIO:
+            fprintf(out, "<@%lld> DISPATCH: [%d](p:%d) to CPU\n", r->clk, r->pid, r->aux[0]);
+            break;
+        case LOG_PREEMPT:
+            fprintf(out, "<@%lld> PREEMPT: DISPATCH [%d] (%d clk) to CPU, [%d] (%d clk) to ready queue\n",
+                    r->clk, r->pid, r->aux[0], r->pid2, r->aux[1]);
+            break;
+        case LOG_PREEMPT_PRIO:
+            fprintf(out, "<@%lld> PREEMPT: [%d](p: %d) (%d clk) to CPU, [%d](p:%d) (%lld clk) to ready queue\n",
+                    r->clk, r->pid, r->aux[0], r->aux[1], r->pid2, r->aux[2], r->arg);
+            break;
+        case LOG_RR_RENEW:
+            fprintf(out, "<@%lld> RR-RENEW: [%d] (%d clk) has no other process to replace it.\n", r->clk, r->pid, r->aux[0]);
+            break;
+        case LOG_RR_SWITCH:
+            fprintf(out, "<@%lld> RR-SWITCH: [%d] (%d clk) to CPU, [%d] (%d clk) to ready queue\n",
+                    r->clk, r->pid, r->aux[0], r->pid2, r->aux[1]);
+            break;
+        case LOG_TERMINATE:
+            fprintf(out, "<@%lld> TERMINATE: [%d] to term queue \n", r->clk, r->pid);
+            break;
+        case LOG_WAIT:
+            if(r->aux[1] > 0){
+                fprintf(out, "<@%lld> WAIT: [%d] (%d I/O clk) to wait queue of device %d\n", r->clk, r->pid, r->aux[0], r->aux[1]-1);
+            }
+            else{
+                fprintf(out, "<@%lld> WAIT: [%d] (%d I/O clk) to wait queue\n", r->clk, r->pid, r->aux[0]);
+            }
+            break;
+        case LOG_IO_START:
+            if(r->aux[1] > 0){
+                fprintf(out, "<@%lld> I/O START: [%d] (%d I/O clock) on device %d\n", r->clk, r->pid, r->aux[0], r->aux[1]-1);
+            }
+            else{
+                fprintf(out, "<@%lld> I/O START: [%d] (%d I/O clock)\n", r->clk, r->pid, r->aux[0]);
+            }
+            break;
+        case LOG_COMPLETE:
+            fprintf(out, "<@%lld> COMPLETE: All processes are terminated\n====LOG END====\n", r->clk);
+            break;
+        case LOG_STOP:
+            fprintf(out, "<@%lld> STOP: max_time reached, %lld processes not terminated\n", r->clk, r->arg);
+            break;
+        case LOG_IDLE:
+            if(r->aux[0] == 0){
+                fprintf(out, "<@%lld> IDLE: CPU and I/O are idle\n", r->clk);
+            }
+            else if(r->aux[0] == 1){
+                fprintf(out, "<@%lld> IDLE: CPU idle\n", r->clk);
+            }
+            else{
+                fprintf(out, "<@%lld> IDLE: CPU is idle\n", r->clk);
+            }
+            break;
+        case LOG_IDLE_SPAN:
+            fprintf(out, "<@%lld> IDLE: CPU is idle for %lld clk\n", r->clk, r->arg);
+            break;
+        case LOG_MIGRATE:
+            fprintf(out, "<@%lld> MIGRATE: [%d] stolen from core %d by core %d\n", r->clk, r->pid, r->aux[0], r->aux[1]);
+            break;
+        case LOG_DEMOTE:
+            fprintf(out, "<@%lld> DEMOTE: [%d] used up its allotment, to level %d\n", r->clk, r->pid, r->aux[0]);
+            break;
+        case LOG_BOOST:
+            fprintf(out, "<@%lld> BOOST: every process back to level 0, [%d] keeps the CPU\n", r->clk, r->pid);
+            break;
+        case LOG_PREEMPT_CFS:
+            fprintf(out, "<@%lld> PREEMPT: [%d] (vruntime %lld behind) to CPU, [%d] to ready queue\n",
+                    r->clk, r->pid, r->arg, r->pid2);
+            break;
+        case LOG_PREEMPT_EDF:
+            fprintf(out, "<@%lld> PREEMPT: [%d] (due at %lld) to CPU, [%d] (due %d later) to ready queue\n",
+                    r->clk, r->pid, r->arg, r->pid2, r->aux[0]);
+            break;
+        case LOG_DEADLINE_MISS:
+            fprintf(out, "<@%lld> DEADLINE MISS: [%d] finished %lld clk late\n", r->clk, r->pid, r->arg);
+            break;
+        case LOG_LOTTERY:
+            if(r->pid == r->pid2){
+                fprintf(out, "<@%lld> LOTTERY: [%d] (%d of %lld tickets) wins again, keeps the CPU\n", r->clk, r->pid, r->aux[0], r->arg);
+            }
+            else if(r->pid2 == 0){
+                fprintf(out, "<@%lld> LOTTERY: [%d] (%d of %lld tickets) wins, to CPU\n", r->clk, r->pid, r->aux[0], r->arg);
+            }
+            else{
+                fprintf(out, "<@%lld> LOTTERY: [%d] (%d of %lld tickets) wins, to CPU, [%d] to ready queue\n",
+                        r->clk, r->pid, r->aux[0], r->arg, r->pid2);
+            }
+            break;
+        case LOG_PREEMPT_STRIDE:
+            fprintf(out, "<@%lld> PREEMPT: [%d] (pass %lld behind) to CPU, [%d] to ready queue\n",
+                    r->clk, r->pid, r->arg, r->pid2);
+            break;
+        case LOG_PREEMPT_MLFQ:
+            fprintf(out, "<@%lld> PREEMPT: [%d] (level %d) to CPU, [%d] (level %d) to ready queue\n",
+                    r->clk, r->pid, r->aux[0], r->pid2, r->aux[1]);
+            break;
+        default:
+            fprintf(out, "<@%lld> UNKNOWN(%d): [%d]\n", r->clk, r->type, r->pid);
+            break;
+    }
+}
+
+
+int print_log_file(const char* path){
+    /*
+    Offline pretty-printer: render a binary log written by an EventLog sink
+    */
+    FILE *in = fopen(path, "rb");
+    if(in == NULL){
+        printf("Error: couldn't open %s\n", path);
+        return 1;
+    }
+    int header[3];
+    if(fread(header, sizeof(int), 3, in) != 3 || header[0] != 0x474c5343 || header[2] != (int)sizeof(LogRec)){
+        printf("Error: %s is not an event log\n", path);
+        fclose(in);
+        return 1;
+    }
+    LogRec buf[1024];
+    size_t n;
+    while((n = fread(buf, sizeof(LogRec), 1024, in)) > 0){
+        for(size_t i=0; i<n; i++){
+            print_log_rec(stdout, &buf[i]);
+        }
+    }
+    fclose(in);
+    return 0;
+}
+
+
+static void _timeline_json_begin(FILE* out, int tracks, int devices){
+    /* trace-event JSON header: the CPU (pid 0) and I/O (pid 1) processes and their tracks */
+    fprintf(out, "{\"displayTimeUnit\":\"ns\",\"otherData\":{\"clk\":\"1 us\"},\"traceEvents\":[\n");
+    fprintf(out, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"args\":{\"name\":\"CPU\"}},\n");
+    fprintf(out, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"I/O\"}}");
+    for(int i=0; i<tracks; i++){
+        fprintf(out, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%d,\"args\":{\"name\":\"core %d\"}}", i, i);
+    }
+    for(int i=0; i<devices; i++){
+        fprintf(out, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"device %d\"}}", i, i);
+    }
+}
+
+
+static void _timeline_json_rec(FILE* out, TlRec* r, int tracks){
+    /* one TlRec as a trace event: segments are complete events, counters counter events, preemptions instants */
+    switch(r->type){
+        case TL_CPU:
+            fprintf(out, ",\n{\"name\":\"%d\",\"cat\":\"cpu\",\"ph\":\"X\",\"ts\":%lld,\"dur\":%lld,\"pid\":0,\"tid\":%d}",
+                    r->pid, r->ts, r->val, r->track);
+            break;
+        case TL_IO:
+            fprintf(out, ",\n{\"name\":\"%d\",\"cat\":\"io\",\"ph\":\"X\",\"ts\":%lld,\"dur\":%lld,\"pid\":1,\"tid\":%d}",
+                    r->pid, r->ts, r->val, r->track);
+            break;
+        case TL_READY:
+            if(tracks > 1){
+                fprintf(out, ",\n{\"name\":\"ready queue (core %d)\",\"ph\":\"C\",\"ts\":%lld,\"pid\":0,\"args\":{\"processes\":%lld}}",
+                        r->track, r->ts, r->val);
+            }
+            else{
+                fprintf(out, ",\n{\"name\":\"ready queue\",\"ph\":\"C\",\"ts\":%lld,\"pid\":0,\"args\":{\"processes\":%lld}}",
+                        r->ts, r->val);
+            }
+            break;
+        case TL_IO_BUSY:
+            fprintf(out, ",\n{\"name\":\"in I/O\",\"ph\":\"C\",\"ts\":%lld,\"pid\":1,\"args\":{\"processes\":%lld}}",
+                    r->ts, r->val);
+            break;
+        case TL_PREEMPT:
+            fprintf(out, ",\n{\"name\":\"preempt\",\"cat\":\"sched\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%lld,\"pid\":0,\"tid\":%d,"
+                    "\"args\":{\"in\":%d,\"out\":%d}}", r->ts, r->track, r->pid, r->pid2);
+            break;
+        default:
+            break;
+    }
+}
+
+
+TimelineOut* open_timeline(const char* path, bool binary, int tracks, int devices){
+    /*
+    Open a timeline export of a simulation with `tracks` cores and `devices` I/O devices.
+    JSON starts with the names of the tracks, binary with a header (magic, version, record size, tracks, devices)
+    */
+    TimelineOut *tl = (TimelineOut*)malloc(sizeof(TimelineOut));
+    tl->out = fopen(path, binary ? "wb" : "w");
+    if(tl->out == NULL){
+        printf("Error: open_timeline() couldn't open %s\n", path);
+        exit(1);
+    }
+    setvbuf(tl->out, NULL, _IOFBF, 1 << 20);
+    tl->binary = binary;
+    tl->buf = (TlRec*)malloc(sizeof(TlRec)*TL_BUF);
+    tl->cnt = 0;
+    tl->total = 0;
+    tl->tracks = tracks;
+    tl->devices = devices;
+    tl->ready = (int*)malloc(sizeof(int)*tracks);
+    for(int i=0; i<tracks; i++){
+        tl->ready[i] = -1;
+    }
+    tl->io_busy = -1;
+    if(binary){
+        int header[5] = {TL_MAGIC, TL_VERSION, (int)sizeof(TlRec), tracks, devices};
+        fwrite(header, sizeof(int), 5, tl->out);
+    }
+    else{
+        _timeline_json_begin(tl->out, tracks, devices);
+    }
+    return tl;
+}
+
+
+static void _timeline_flush(TimelineOut* tl){
+    /* write out the buffered records */
+    if(tl->binary){
+        fwrite(tl->buf, sizeof(TlRec), tl->cnt, tl->out);
+    }
+    else{
+        for(int i=0; i<tl->cnt; i++){
+            _timeline_json_rec(tl->out, &tl->buf[i], tl->tracks);
+        }
+    }
+    tl->cnt = 0;
+}
+
+
+void timeline_rec(TimelineOut* tl, int type, int track, long long ts, long long val, int pid, int pid2){
+    /* buffer one record (written out when the buffer is full) */
+    if(tl->cnt == TL_BUF){
+        _timeline_flush(tl);
+    }
+    TlRec *r = &tl->buf[tl->cnt++];
+    r->ts = ts;
+    r->val = val;
+    r->type = type;
+    r->track = track;
+    r->pid = pid;
+    r->pid2 = pid2;
+    tl->total++;
+}
+
+
+void timeline_counters(Table* tbl){
+    /*
+    Export the ready queue length of every core and the number of processes in I/O if they changed.
+    Called once per simulated clk: the event engine only simulates the clks at which they can change
+    */
+    TimelineOut *tl = tbl->tl_out;
+    for(int i=0; i<tl->tracks; i++){
+        int n = (tbl->cores != NULL) ? tbl->cores[i]->ready_q->cnt : tbl->ready_q->cnt;
+        if(n != tl->ready[i]){
+            tl->ready[i] = n;
+            timeline_rec(tl, TL_READY, i, tbl->clk, n, 0, 0);
+        }
+    }
+    if(tbl->io->busy != tl->io_busy){
+        tl->io_busy = tbl->io->busy;
+        timeline_rec(tl, TL_IO_BUSY, 0, tbl->clk, tl->io_busy, 0, 0);
+    }
+}
+
+
+void close_timeline(TimelineOut* tl){
+    _timeline_flush(tl);
+    if(!tl->binary){
+        fprintf(tl->out, "\n]}\n");
+    }
+    fclose(tl->out);
+    free(tl->buf);
+    free(tl->ready);
+    free(tl);
+}
+
+
+int print_timeline_file(const char* path){
+    /*
+    Convert a binary timeline export to trace-event JSON on stdout (--print-timeline)
+    */
+    FILE *in = fopen(path, "rb");
+    if(in == NULL){
+        printf("Error: couldn't open %s\n", path);
+        return 1;
+    }
+    int header[5];
+    if(fread(header, sizeof(int), 5, in) != 5 || header[0] != TL_MAGIC || header[1] != TL_VERSION ||
+       header[2] != (int)sizeof(TlRec) || header[3] < 1 || header[4] < 0){
+        printf("Error: %s is not a binary timeline\n", path);
+        fclose(in);
+        return 1;
+    }
+    _timeline_json_begin(stdout, header[3], header[4]);
+    TlRec buf[1024];
+    size_t n;
+    while((n = fread(buf, sizeof(TlRec), 1024, in)) > 0){
+        for(size_t i=0; i<n; i++){
+            _timeline_json_rec(stdout, &buf[i], header[3]);
+        }
+    }
+    printf("\n]}\n");
+    fclose(in);
+    return 0;
+}
+
+
+EventQueue* create_event_queue(int cap){
+    /*
+    Create an empty EventQueue (min-heap on Event.time) with room for `cap` events
+    */
+    EventQueue *eq = (EventQueue*)malloc(sizeof(EventQueue));
+    eq->cap = (cap > 0) ? cap : 16;
+    eq->heap = (Event*)malloc(sizeof(Event)*eq->cap);
+    eq->cnt = 0;
+    eq->allocs = 0;
+
+    return eq;
+}
+
+
+void push_event(EventQueue* eq, long long time, int type, int pid){
+    /*
+    Insert an Event into the heap (sift up)
+    */
+    if(eq->cnt == eq->cap){
+        eq->cap *= 2;
+        eq->heap = (Event*)realloc(eq->heap, sizeof(Event)*eq->cap);
+        eq->allocs++;
+    }
+    int i = eq->cnt++;
+    while(i > 0){
+        int parent = (i-1)/2;
+        if(eq->heap[parent].time <= time){
+            break;
+        }
+        eq->heap[i] = eq->heap[parent];
+        i = parent;
+    }
+    eq->heap[i].time = time;
+    eq->heap[i].type = type;
+    eq->heap[i].pid = pid;
+}
+
+
+Event pop_event(EventQueue* eq){
+    /*
+    Remove and return the earliest Event (sift down). Caller must check eq->cnt > 0
+    */
+    Event top = eq->heap[0];
+    Event last = eq->heap[--eq->cnt];
+    int i = 0;
+    while(1){
+        int child = 2*i + 1;
+        if(child >= eq->cnt){
+            break;
+        }
+        if(child+1 < eq->cnt && eq->heap[child+1].time < eq->heap[child].time){
+            child++;
+        }
+        if(last.time <= eq->heap[child].time){
+            break;
+        }
+        eq->heap[i] = eq->heap[child];
+        i = child;
+    }
+    if(eq->cnt > 0){
+        eq->heap[i] = last;
+    }
+    return top;
+}
+
+
+static bool _io_blocks(Table* tbl){
+    /* non-preemptive algos on a single CPU wait while a process is in I/O (cores never wait) */
+    return tbl->core_id < 0 && tbl->io->busy > 0;
+}
+
+
+// pick hooks: the schedule step of CPU() for one algorithm.
+// false: the CPU is idle this clk and the hook already recorded it (CPU() returns -1 right away)
+
+ALWAYS_INLINE bool _pick_fcfs(Table* tbl, int _quantum){
+    /* FCFS: the head of the ready queue, once running_p is done (waits for I/O) */
+    if(tbl->running_p == NULL && !_io_blocks(tbl)){
+        if(tbl->ready_q->head == NULL){
+            gannt_record(&tbl->gannt, tbl->clk, 1, -1);
+            // log message: IDLE
+            LOG_EVENT(tbl, tbl->clk, LOG_IDLE, 0, 0, 0, 0, 0, 0);
+            return false;  // CPU and I/O IDLE: running_p == NULL
+        }
+        // DISPATCH
+        tbl->running_p = tbl->ready_q->head->p;
+        LOG_EVENT(tbl, tbl->clk, LOG_DISPATCH, tbl->running_p->pid, 0, 0, 0, 0, 0);
+        tbl->running_p->state = 2;  // running
+        tbl->dispatches++;
+        dequeue(tbl->ready_q, tbl->running_p);
+    }
+    return true;
+}
+
+
+ALWAYS_INLINE bool _pick_sjf(Table* tbl, int _quantum){
+    /* SJF (non-preemptive): the shortest job, once running_p is done (waits for I/O) */
+    if(tbl->running_p == NULL && !_io_blocks(tbl)){
+        Process *out = _SJF(tbl->ready_q);
+        if(out == NULL){
+            gannt_record(&tbl->gannt, tbl->clk, 1, -1);
+            // log message: IDLE
+            LOG_EVENT(tbl, tbl->clk, LOG_IDLE, 0, 0, 0, 0, 0, 0);
+            return false;  // CPU and I/O IDLE: running_p == NULL
+        }
+        // log message: DISPATCH
+        LOG_EVENT(tbl, tbl->clk, LOG_DISPATCH, out->pid, 0, 0, 0, 0, 0);
+        tbl->running_p = out;
+        tbl->running_p->state = 2;  // running
+        tbl->dispatches++;
+        dequeue(tbl->ready_q, tbl->running_p);
+    }
+    return true;
+}
+
+
+ALWAYS_INLINE bool _pick_srtf(Table* tbl, int _quantum){
+    /* preemptive SJF: the shortest remaining burst, preempts running_p */
+    Process *out = _SJF(tbl->ready_q);   // NULL if ready_q is empty, else returns a Process
+    if(out != NULL){
+        if(tbl->running_p == NULL){
+            tbl->running_p = out;
+            LOG_EVENT(tbl, tbl->clk, LOG_DISPATCH, tbl->running_p->pid, 0, 0, 0, 0, 0);
+            tbl->running_p->state = 2; // running
+            tbl->dispatches++;
+            dequeue(tbl->ready_q, tbl->running_p);
+        }
+        else if(tbl->running_p->cpu_burst_rem > out->cpu_burst_rem){   // preempt running_p with out
+            LOG_EVENT(tbl, tbl->clk, LOG_PREEMPT, out->pid, tbl->running_p->pid,
+                      out->cpu_burst_rem, tbl->running_p->cpu_burst_rem, 0, 0);
+            tbl->running_p->state = 1;  // preempt  to ready
+            enqueue(tbl->ready_q, tbl->running_p);
+            tbl->running_p = out;
+            tbl->running_p->state = 2;  // running
+            tbl->dispatches++;
+            dequeue(tbl->ready_q, tbl->running_p);
+        }
+        // else: keep running_p
+    }
+    // else: if out == NULL --> keep running_p whether NULL or not.
+    return true;
+}
+
+
+ALWAYS_INLINE bool _pick_prio(Table* tbl, int _quantum){
+    /* priority w/o preemption: the highest priority, once running_p is done (waits for I/O) */
+    if(tbl->running_p == NULL && !_io_blocks(tbl)){
+        Process *out = _PRIO(tbl->ready_q, NULL);
+        if(out == NULL){
+            gannt_record(&tbl->gannt, tbl->clk, 1, -1);
+            // log message: IDLE
+            LOG_EVENT(tbl, tbl->clk, LOG_IDLE, 0, 0, 0, 0, 0, 0);
+            return false;  // CPU and I/O IDLE: running_p == NULL
+        }
+        // log message: DISPATCH
+        LOG_EVENT(tbl, tbl->clk, LOG_DISPATCH_PRIO, out->pid, 0, out->priority, 0, 0, 0);
+        tbl->running_p = out;
+        tbl->running_p->state = 2;  // running
+        tbl->dispatches++;
+        dequeue(tbl->ready_q, tbl->running_p);
+    }
+    return true;
+}
+
+
+ALWAYS_INLINE bool _pick_pprio(Table* tbl, int _quantum){
+    /* priority w/ preemption: the highest priority, preempts running_p */
+    Process *out = _PRIO(tbl->ready_q, tbl->running_p);
+    if(out == NULL){
+        return true; // CPU is IDLE
+    }
+    // out != NULL
+    if(tbl->running_p == NULL){
+        tbl->running_p = out;
+        LOG_EVENT(tbl, tbl->clk, LOG_DISPATCH_PPRIO, tbl->running_p->pid, 0, tbl->running_p->priority, 0, 0, 0);
+        tbl->running_p->state = 2; // running
+        tbl->dispatches++;
+        dequeue(tbl->ready_q, tbl->running_p);
+    }
+    if(out != tbl->running_p){  // Premption: `out` replaces running_p
+        LOG_EVENT(tbl, tbl->clk, LOG_PREEMPT_PRIO, out->pid, tbl->running_p->pid,
+                  out->priority, out->cpu_burst_rem, tbl->running_p->priority, tbl->running_p->cpu_burst_rem);
+        tbl->running_p->state = 1;  // preempt  to ready queue
+        enqueue(tbl->ready_q, tbl->running_p);
+        tbl->running_p = out;
+        tbl->running_p->state = 2;  // running
+        tbl->dispatches++;
+        dequeue(tbl->ready_q, tbl->running_p);  // remove `out` from ready queue
+    }
+    return true;
+}
+
+
+ALWAYS_INLINE bool _pick_rr(Table* tbl, int _quantum){
+    /* Round Robin: identical time quantum, no priority, always preempt, renew quantum if no process in ready queue */
+    if(tbl->ready_q->head == NULL){ // empty ready queue
+        if(tbl->running_p == NULL){
+            gannt_record(&tbl->gannt, tbl->clk, 1, -1);
+            // log message: IDLE
+            LOG_EVENT(tbl, tbl->clk, LOG_IDLE, 0, 0, 1, 0, 0, 0);
+            return false;
+        }
+        if(tbl->quantum == 0){
+            // no other process to replace running_p --> renew quantum for running_p
+            LOG_EVENT(tbl, tbl->clk, LOG_RR_RENEW, tbl->running_p->pid, 0, tbl->running_p->cpu_burst_rem, 0, 0, 0);
+            tbl->quantum = _quantum;    // reset quantum
+            return true;
+        }
+    }
+    if(tbl->running_p == NULL){
+        tbl->running_p = tbl->ready_q->head->p; // first process in ready queue
+        LOG_EVENT(tbl, tbl->clk, LOG_DISPATCH, tbl->running_p->pid, 0, 0, 0, 0, 0);
+        tbl->running_p->state = 2; // running
+        tbl->dispatches++;
+        dequeue(tbl->ready_q, tbl->running_p);
+        tbl->quantum = _quantum;    // reset quantum
+    }
+    else if(tbl->quantum == 0){  // running_p is not finished, quantum expired
+        Process *out = tbl->ready_q->head->p;
+        LOG_EVENT(tbl, tbl->clk, LOG_RR_SWITCH, out->pid, tbl->running_p->pid,
+                  out->cpu_burst_rem, tbl->running_p->cpu_burst_rem, 0, 0);
+
+        tbl->running_p->state = 1;  // preempt  to ready queue
+        enqueue(tbl->ready_q, tbl->running_p);
+
+        tbl->running_p = out;
+        tbl->running_p->state = 2;  // running
+        tbl->dispatches++;
+        dequeue(tbl->ready_q, tbl->running_p);  // remove `out` from ready queue
+
+        tbl->quantum = _quantum;    // reset quantum
+    }
+    return true;
+}
+
+
+ALWAYS_INLINE bool _pick_mlfq(Table* tbl, int _quantum){
+    /*
+    MLFQ: RR within a level with the quantum of the level, the highest non-empty level first (preempt),
+    demote a process that used up its allotment, every process back to the top level every boost clks
+    */
+    Queue *q = tbl->ready_q;
+    bool expired = false;   // running_p used up its allotment
+    if(tbl->running_p != NULL){
+        if(tbl->running_p->epoch < _mlfq_epoch(q)){
+            // priority boost: running_p starts over at the top level (the queued processes follow in mlfq_top())
+            LOG_EVENT(tbl, tbl->clk, LOG_BOOST, tbl->running_p->pid, 0, 0, 0, 0, 0);
+            tbl->running_p->level = 0;
+            tbl->running_p->slice = q->lq[0];
+            tbl->running_p->epoch = _mlfq_epoch(q);
+        }
+        else if(tbl->running_p->slice == 0){
+            // allotment used up: one level down (the lowest level is plain RR)
+            expired = true;
+            if(tbl->running_p->level < q->levels-1){
+                tbl->running_p->level++;
+                LOG_EVENT(tbl, tbl->clk, LOG_DEMOTE, tbl->running_p->pid, 0, tbl->running_p->level, 0, 0, 0);
+            }
+            tbl->running_p->slice = q->lq[tbl->running_p->level];
+        }
+    }
+    Process *out = _MLFQ(q);
+    if(out == NULL){
+        return true;  // keep running_p whether NULL or not
+    }
+    if(tbl->running_p != NULL){
+        int lvl = _mlfq_level(q, out);
+        if(lvl > tbl->running_p->level || (lvl == tbl->running_p->level && !expired)){
+            return true;  // keep running_p
+        }
+        // preempted by a higher level, or next in turn on the same level
+        LOG_EVENT(tbl, tbl->clk, LOG_PREEMPT_MLFQ, out->pid, tbl->running_p->pid, lvl, tbl->running_p->level, 0, 0);
+        tbl->running_p->state = 1;  // preempt to ready queue (keeps what is left of its allotment)
+        enqueue(q, tbl->running_p);
+    }
+    else{
+        LOG_EVENT(tbl, tbl->clk, LOG_DISPATCH, out->pid, 0, 0, 0, 0, 0);
+    }
+    tbl->running_p = out;
+    tbl->running_p->state = 2;  // running
+    tbl->dispatches++;
+    dequeue(q, tbl->running_p);
+    if(tbl->running_p->slice < 0){
+        tbl->running_p->slice = q->lq[tbl->running_p->level];
+    }
+    return true;
+}
+
+
+ALWAYS_INLINE bool _pick_cfs(Table* tbl, int _quantum){
+    /*
+    CFS (fair share): the process with the smallest vruntime (CPU time scaled by the weight of its priority) runs,
+    preempted once it ran _quantum clks (minimum granularity) and another process is behind it
+    */
+    Process *out = _TOP(tbl->ready_q);
+    if(out == NULL){
+        return true;  // keep running_p whether NULL or not
+    }
+    if(tbl->running_p == NULL){
+        LOG_EVENT(tbl, tbl->clk, LOG_DISPATCH, out->pid, 0, 0, 0, 0, 0);
+    }
+    else if(tbl->quantum <= 0 && out->vruntime < tbl->running_p->vruntime){
+        LOG_EVENT(tbl, tbl->clk, LOG_PREEMPT_CFS, out->pid, tbl->running_p->pid, 0, 0, 0,
+                  tbl->running_p->vruntime - out->vruntime);
+        tbl->running_p->state = 1;  // preempt to ready queue
+        enqueue(tbl->ready_q, tbl->running_p);
+    }
+    else{
+        return true;  // keep running_p
+    }
+    tbl->running_p = out;
+    tbl->running_p->state = 2;  // running
+    tbl->dispatches++;
+    dequeue(tbl->ready_q, tbl->running_p);
+    tbl->quantum = _quantum;    // minimum granularity
+    return true;
+}
+
+
+ALWAYS_INLINE bool _pick_edf(Table* tbl, int _quantum){
+    /* EDF: earliest absolute deadline first, preemptive (no deadline: after every process with one) */
+    Process *out = _TOP(tbl->ready_q);
+    if(out == NULL){
+        return true;  // keep running_p whether NULL or not
+    }
+    if(tbl->running_p == NULL){
+        LOG_EVENT(tbl, tbl->clk, LOG_DISPATCH, out->pid, 0, 0, 0, 0, 0);
+    }
+    else if(_abs_deadline(out) < _abs_deadline(tbl->running_p)){
+        // a0: how much later the deadline of running_p is (-1: more than INT_MAX)
+        LOG_EVENT(tbl, tbl->clk, LOG_PREEMPT_EDF, out->pid, tbl->running_p->pid,
+                  (_abs_deadline(tbl->running_p) - _abs_deadline(out) > INT_MAX) ? -1 :
+                  (int)(_abs_deadline(tbl->running_p) - _abs_deadline(out)), 0, 0, _abs_deadline(out));
+        tbl->running_p->state = 1;  // preempt to ready queue
+        enqueue(tbl->ready_q, tbl->running_p);
+    }
+    else{
+        return true;  // keep running_p
+    }
+    tbl->running_p = out;
+    tbl->running_p->state = 2;  // running
+    tbl->dispatches++;
+    dequeue(tbl->ready_q, tbl->running_p);
+    return true;
+}
+
+
+ALWAYS_INLINE bool _pick_lottery(Table* tbl, int _quantum){
+    /* Lottery: every quantum, a draw among the tickets of the ready processes and running_p */
+    if(tbl->running_p != NULL && tbl->quantum > 0){
+        return true;  // keep running_p
+    }
+    if(tbl->ready_q->cnt == 0){
+        if(tbl->running_p != NULL){
+            LOG_EVENT(tbl, tbl->clk, LOG_RR_RENEW, tbl->running_p->pid, 0, tbl->running_p->cpu_burst_rem, 0, 0, 0);
+            tbl->quantum = _quantum;    // nobody to draw against: renew quantum
+        }
+        return true;  // keep running_p whether NULL or not
+    }
+    if(tbl->running_p != NULL){
+        tbl->running_p->state = 1;  // running_p takes part in the draw from the ready queue
+        enqueue(tbl->ready_q, tbl->running_p);
+    }
+    long long ticket;
+    Process *out = _LOTTERY(tbl->ready_q, &tbl->rng, &ticket);
+    LOG_EVENT(tbl, tbl->clk, LOG_LOTTERY, out->pid, (tbl->running_p != NULL) ? tbl->running_p->pid : 0,
+              out->tickets, 0, 0, tbl->ready_q->tickets);
+    if(out != tbl->running_p){
+        tbl->dispatches++;
+    }
+    tbl->running_p = out;
+    tbl->running_p->state = 2;  // running
+    dequeue(tbl->ready_q, tbl->running_p);
+    tbl->quantum = _quantum;    // reset quantum
+    return true;
+}
+
+
+ALWAYS_INLINE bool _pick_stride(Table* tbl, int _quantum){
+    /* Stride: smallest pass first, every quantum (ties go to the ready process) */
+    if(tbl->running_p != NULL && tbl->quantum > 0){
+        return true;  // keep running_p
+    }
+    Process *out = _TOP(tbl->ready_q);
+    if(out == NULL){
+        if(tbl->running_p != NULL){
+            LOG_EVENT(tbl, tbl->clk, LOG_RR_RENEW, tbl->running_p->pid, 0, tbl->running_p->cpu_burst_rem, 0, 0, 0);
+            tbl->quantum = _quantum;    // no other process: renew quantum
+        }
+        return true;  // keep running_p whether NULL or not
+    }
+    if(tbl->running_p == NULL){
+        LOG_EVENT(tbl, tbl->clk, LOG_DISPATCH, out->pid, 0, 0, 0, 0, 0);
+    }
+    else if(out->pass <= tbl->running_p->pass){
+        LOG_EVENT(tbl, tbl->clk, LOG_PREEMPT_STRIDE, out->pid, tbl->running_p->pid, 0, 0, 0,
+                  tbl->running_p->pass - out->pass);
+        tbl->running_p->state = 1;  // preempt to ready queue
+        enqueue(tbl->ready_q, tbl->running_p);
+    }
+    else{
+        tbl->quantum = _quantum;    // still the smallest pass: another quantum
+        return true;
+    }
+    tbl->running_p = out;
+    tbl->running_p->state = 2;  // running
+    tbl->dispatches++;
+    dequeue(tbl->ready_q, tbl->running_p);
+    tbl->quantum = _quantum;    // reset quantum
+    return true;
+}
+
+
+// charge hooks: running_p ran `ticks` more clks (1 from CPU(), the whole gap from fast_forward())
+
+ALWAYS_INLINE void _charge_none(Table* tbl, Process* p, long long ticks){
+}
+
+
+ALWAYS_INLINE void _charge_quantum(Table* tbl, Process* p, long long ticks){
+    /* Round Robin, lottery: quantum */
+    tbl->quantum -= ticks;
+}
+
+
+ALWAYS_INLINE void _charge_mlfq(Table* tbl, Process* p, long long ticks){
+    /* MLFQ allotment */
+    p->slice -= ticks;
+}
+
+
+ALWAYS_INLINE void _charge_cfs(Table* tbl, Process* p, long long ticks){
+    /* CFS: granularity and virtual runtime */
+    tbl->quantum -= ticks;
+    p->vruntime += ticks * _cfs_delta(p);
+    _cfs_update_min(tbl);
+}
+
+
+ALWAYS_INLINE void _charge_stride(Table* tbl, Process* p, long long ticks){
+    /* stride: quantum and pass */
+    tbl->quantum -= ticks;
+    p->pass += ticks * _stride(p);
+    _stride_update_global(tbl);
+}
+
+
+// timer hooks: events at which the pick hook could replace the running process `p` (after clk)
+
+ALWAYS_INLINE void _timers_none(Table* tbl, EventQueue* eq, Process* p, long long clk){
+}
+
+
+ALWAYS_INLINE void _timers_quantum(Table* tbl, EventQueue* eq, Process* p, long long clk){
+    // quantum is checked before it is decremented, so it reads 0 one clk after the last decrement
+    push_event(eq, clk + tbl->quantum + 1, 3, p->pid);
+}
+
+
+ALWAYS_INLINE void _timers_mlfq(Table* tbl, EventQueue* eq, Process* p, long long clk){
+    push_event(eq, clk + p->slice + 1, 3, p->pid);     // allotment used up (checked like the RR quantum)
+    if(tbl->ready_q->boost > 0){
+        push_event(eq, (clk / tbl->ready_q->boost + 1) * tbl->ready_q->boost, 3, p->pid);  // next boost
+    }
+}
+
+
+ALWAYS_INLINE void _timers_cfs(Table* tbl, EventQueue* eq, Process* p, long long clk){
+    if(tbl->ready_q->cnt > 0){
+        // clks until p has run its granularity and its vruntime passed the leftmost one (checked like the RR quantum)
+        long long wait = (tbl->quantum > 0) ? tbl->quantum : 0;
+        long long lead = tbl->ready_q->heap[0]->vruntime - p->vruntime;
+        long long pass = (lead < 0) ? 0 : lead / _cfs_delta(p) + 1;
+        push_event(eq, clk + ((pass > wait) ? pass : wait) + 1, 3, p->pid);
+    }
+}
+
+
+// hook of `algo`: a jump table where algo is only known at run time, a direct call in the specialized loops
+
+ALWAYS_INLINE bool _pick(const int algo, Table* tbl, int _quantum){
+    switch(algo){
+#define X(id, name, label, title, charge, timers, preempt, prio, quantum, queue) case id: return _pick_##name(tbl, _quantum);
+        POLICIES(X)
+#undef X
+    }
+    printf("Error: CPU() algo not implemented\n");
+    exit(1);
+}
+
+
+ALWAYS_INLINE void _charge(const int algo, Table* tbl, Process* p, long long ticks){
+    switch(algo){
+#define X(id, name, label, title, charge, timers, preempt, prio, quantum, queue) case id: _charge_##charge(tbl, p, ticks); break;
+        POLICIES(X)
+#undef X
+    }
+}
+
+
+ALWAYS_INLINE void _timers(const int algo, Table* tbl, EventQueue* eq, Process* p, long long clk){
+    switch(algo){
+#define X(id, name, label, title, charge, timers, preempt, prio, quantum, queue) case id: _timers_##timers(tbl, eq, p, clk); break;
+        POLICIES(X)
+#undef X
+    }
+}
+
+
+ALWAYS_INLINE void _schedule_events(Table* tbl, EventQueue* eq, const int algo){
+    /*
+    Push the events that follow from the current state (called after clk has been fully simulated)
+
+    Between two events nothing but counters change: running_p burns its CPU burst,
+    the I/O devices burn their bursts and quantum counts down.
+    Every clk at which CPU(), io_service() or wait_to_ready() could do anything else is pushed here.
+    Events that go stale (e.g. running_p got preempted) only cost one extra simulated clk.
+    */
+    long long clk = tbl->clk;
+
+    if(tbl->running_p != NULL){
+        Process *p = tbl->running_p;
+        int end = p->cpu_burst_rem;    // clk offset at which the burst finishes
+        if(p->io_burst_start > 0 && p->io_burst_start < end){
+            end = p->io_burst_start;    // I/O request comes first
+        }
+        push_event(eq, clk + end, 1, p->pid);
+        _timers(algo, tbl, eq, p, clk);
+    }
+    else if(tbl->ready_q->cnt > 0){
+        // CPU is free and someone is ready: dispatch next clk (non-preemptive algos wait for I/O instead)
+        bool blocked = !_preemptive(algo) && tbl->io->busy > 0;
+        if(!blocked){
+            push_event(eq, clk + 1, 4, 0);
+        }
+    }
+
+    if(tbl->io->done->cnt > 0){
+        // earliest I/O completion (wait_to_ready() takes it at done_clk)
+        push_event(eq, tbl->io->done->heap[0].time, 2, 0);
+    }
+    if(tbl->io->start_cnt > 0){
+        push_event(eq, clk + 1, 2, 0);  // io_service() starts an idle device next clk
+    }
+}
+
+
+void schedule_events(Table* tbl, EventQueue* eq, int algo){
+    /* _schedule_events() for an algo only known at run time */
+    _schedule_events(tbl, eq, algo);
+}
+
+
+long long next_event_time(Table* tbl, EventQueue* eq){
+    /*
+    Discard events that are already in the past and return the time of the next one (-1 if none)
+    */
+    while(eq->cnt > 0 && eq->heap[0].time <= tbl->clk){
+        pop_event(eq);
+    }
+    return (eq->cnt > 0) ? eq->heap[0].time : -1;
+}
+
+
+ALWAYS_INLINE void _fast_forward(Table* tbl, const int algo, long long ticks){
+    /*
+    Apply `ticks` uneventful clock cycles after tbl->clk in one go.
+    Produces exactly what the tick loop would: burst/quantum countdowns and the gannt chart.
+    (wait times need nothing: they are accounted when processes leave their queue)
+    (tbl->clk itself is moved by the caller)
+    */
+    if(ticks <= 0){
+        return;
+    }
+    share_clock(tbl->stats, 1, ticks);
+    Process *p = tbl->running_p;
+    gannt_record(&tbl->gannt, tbl->clk+1, ticks, (p == NULL) ? -1 : p->pid);
+    if(p != NULL){
+        p->cpu_burst_rem -= ticks;
+        p->io_burst_start -= ticks;
+        _charge(algo, tbl, p, ticks);
+    }
+    else{
+        // log message: IDLE
+        LOG_EVENT(tbl, tbl->clk+1, LOG_IDLE_SPAN, 0, 0, 0, 0, 0, ticks);
+    }
+}
+
+
+void fast_forward(Table* tbl, int algo, long long ticks){
+    /* _fast_forward() for an algo only known at run time */
+    _fast_forward(tbl, algo, ticks);
+}
+
+
+ALWAYS_INLINE int _cpu(Table* tbl, const int algo, int _quantum){
+    /* CPU() with the hooks of `algo` */
+
+    // 1. schedule a Process to execute
+    Process *prev = tbl->running_p;
+    if(!_pick(algo, tbl, _quantum)){
+        return -1;
+    }
+    if(tbl->tl_out != NULL && prev != NULL && prev != tbl->running_p && prev->state == 1){
+        // running_p went back to the ready queue: preempted (or its quantum is over)
+        timeline_rec(tbl->tl_out, TL_PREEMPT, (tbl->core_id < 0) ? 0 : tbl->core_id, tbl->clk, 0,
+                     (tbl->running_p != NULL) ? tbl->running_p->pid : 0, prev->pid);
+    }
+    if(tbl->running_p == NULL){
+        gannt_record(&tbl->gannt, tbl->clk, 1, -1);
+        // log message: CPU IDLE
+        LOG_EVENT(tbl, tbl->clk, LOG_IDLE, 0, 0, 2, 0, 0, 0);
+        return -1;
+    }
+
+    // 2. compute
+    _charge(algo, tbl, tbl->running_p, 1);  // quantum, allotment, vruntime, pass
+    // compute CPU burst
+    if(tbl->running_p->first_run < 0){
+        tbl->running_p->first_run = tbl->clk;   // response time
+    }
+    tbl->running_p->cpu_burst_rem--;
+    gannt_record(&tbl->gannt, tbl->clk, 1, tbl->running_p->pid);
+    // check if running_p is finished
+
+    if(tbl->running_p->cpu_burst_rem == 0){
+        LOG_EVENT(tbl, tbl->clk, LOG_TERMINATE, tbl->running_p->pid, 0, 0, 0, 0, 0);
         tbl->running_p->state = 4; // terminated
         tbl->running_p->finish_time = tbl->clk;
         tbl->running_p->turnaround_time =
         (tbl->running_p->finish_time - tbl->running_p->arrival_time);
-        
-        enqueue(tbl->term_q, tbl->running_p);   // create Node at term
-        
+
+        retire_process(tbl, tbl->running_p);    // to term queue
+
         tbl->running_p = NULL;
         return 0;
     }
-    // I/O countdown
-    tbl->running_p->io_burst_start--;
-    // check if I/O must be serviced
-    if(tbl->running_p->io_burst_start == 0){
-        // log message: WAIT
-        printf("<@%d> WAIT: [%d] (%d I/O clk) to wait queue\n", tbl->clk+1, tbl->running_p->pid, tbl->running_p->io_burst_rem);
-        tbl->running_p->state = 3; // waiting
-        tbl->running_p->io_burst_start = -1; //I/O only once
-        enqueue(tbl->wait_q, tbl->running_p);
-        tbl->running_p = NULL;
-        return -1;
-    }     
-    
-    return tbl->running_p->cpu_burst_rem;
+    // I/O countdown
+    tbl->running_p->io_burst_start--;
+    // check if I/O must be serviced
+    if(tbl->running_p->io_burst_start == 0){
+        // log message: WAIT
+        LOG_EVENT(tbl, tbl->clk+1, LOG_WAIT, tbl->running_p->pid, 0, tbl->running_p->io_burst_rem,
+                  (tbl->io->num_devices > 1) ? tbl->running_p->io_dev+1 : 0, 0, 0);
+        tbl->running_p->state = 3; // waiting
+        tbl->running_p->io_burst_start = -1; // until the burst is done and the next one is loaded (io_complete())
+        share_leave(tbl->stats, tbl->running_p);
+        request_io(tbl->io, tbl->running_p);
+        tbl->running_p = NULL;
+        return -1;
+    }
+
+    return tbl->running_p->cpu_burst_rem;
+}
+
+
+int CPU(Table* tbl, int algo, int _quantum){
+    /* CPU()
+    1. Schedule: select a Process to execute according to the scheduling algorithm specified by `algo`
+        - if preemptive:
+            - if running_p is NULL: DISPATCH
+            - if running_p is not NULL: PREEMPT (if higher priority process in ready_q)
+        - if non-preemptive:
+            - if running_p is NULL and I/O is IDLE: DISPATCH
+            - if running_p is NULL but I/O is BUSY: WAIT
+            - if running_p is not NULL: keep running_p
+    
+        (the _pick_<name>() hook of the algorithm, see POLICIES)
+
+    2. Compute:
+        - Charge 1 clk to the policy (_charge_<name>()): tbl->quantum (RR, lottery), running_p->slice (MLFQ),
+          tbl->quantum and running_p->vruntime (CFS) or running_p->pass (stride)
+        - Compute CPU burst for 1 CLK --> check if running_p is finished
+        - Decrement running_p->io_burst_start --> check if I/O must be serviced
+    
+    Parameters
+    ----------
+    Table* tbl: tbl keeps track of all queues, running process, current time and other options required for scheduling
+
+    int algo: specifies the scheduling algorithm to be used
+        0: FCFS
+        1: SJF w/o preemption
+        2: SJF w/ preemption
+        3: Priority w/o preemption
+        4: Priority w/ preemption
+        5: Round Robin - identical time quantum, no priority, always preempt
+        6: MLFQ - RR within a level with the quantum of the level, the highest non-empty level first (preempt),
+           demote a process that used up its allotment, every process back to the top level every boost clks
+        7: CFS - the process with the smallest vruntime (CPU time scaled by the weight of its priority) runs,
+           preempted once it ran _quantum clks (minimum granularity) and another process is behind it
+        8: EDF - earliest absolute deadline first, preemptive
+        9: Lottery - a draw among the tickets of the ready processes every quantum
+        10: Stride - smallest pass first, every quantum
+
+    The simulation loops call _cpu() with a constant algo instead, which leaves only the hooks of that algorithm
+
+    Returns
+    -------
+    int: -1 if CPU is IDLE
+          0 if running_p is finished (tbl->running_p == NULL)
+          else: tbl->running_p->cpu_burst_rem
+     */
+    return _cpu(tbl, algo, _quantum);
+}
+
+
+int io_service(Table* tbl, int algo){
+    /* Start I/O on the idle devices that have waiting processes
+    1. Schedule: for every device in io->start, select the first Process of its wait queue to perform I/O
+
+    2. I/O service: the burst is not counted down clk by clk, the device is done at clk + io_burst_rem
+        (pushed to io->done, wait_to_ready() takes the process off the device then)
+
+    Returns
+    -------
+    number of processes in I/O (waiting or being serviced), 0 if all devices are idle
+     */
+    DeviceSet *io = tbl->io;
+    for(int i=0; i<io->start_cnt; i++){
+        Device *d = &io->dev[io->start[i]];
+        d->pending = false;
+        if(d->io_p != NULL || d->wait_q->head == NULL){
+            continue;
+        }
+        d->io_p = d->wait_q->head->p;
+        LOG_EVENT(tbl, tbl->clk, LOG_IO_START, d->io_p->pid, 0, d->io_p->io_burst_rem,
+                  (io->num_devices > 1) ? io->start[i]+1 : 0, 0, 0);
+        dequeue(d->wait_q, d->io_p);
+        d->io_p->state = 3;   // waiting
+        d->done_clk = tbl->clk + d->io_p->io_burst_rem;
+        d->busy += d->io_p->io_burst_rem;
+        if(tbl->tl_out != NULL){
+            timeline_rec(tbl->tl_out, TL_IO, io->start[i], tbl->clk, d->io_p->io_burst_rem, d->io_p->pid, 0);
+        }
+        push_event(io->done, d->done_clk, 0, io->start[i]);
+    }
+    io->start_cnt = 0;
+    return io->busy;
+}
+
+
+static Process* _sjf_pick(Queue* q);
+static Process* _prio_pick(Queue* q, Process* running_p);
+
+
+static inline long long _now_ns(void){
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec*1000000000LL + t.tv_nsec;
+}
+
+
+Process* _SJF(Queue* q){
+    /*
+    Returns the process with the shortest CPU burst time in the queue (_sjf_pick()).
+    Profiled queues count the calls and time one in SEL_SAMPLE of them
+    */
+    if(!q->prof || (q->sel_calls++ % SEL_SAMPLE) != 0){
+        return _sjf_pick(q);
+    }
+    long long t0 = _now_ns();
+    Process *p = _sjf_pick(q);
+    q->sel_ns += _now_ns() - t0;
+    q->sel_timed++;
+    return p;
+}
+
+
+Process* _PRIO(Queue* q, Process* running_p){
+    /* Returns the process with the highest priority, or running_p (_prio_pick()). Profiled like _SJF() */
+    if(!q->prof || (q->sel_calls++ % SEL_SAMPLE) != 0){
+        return _prio_pick(q, running_p);
+    }
+    long long t0 = _now_ns();
+    Process *p = _prio_pick(q, running_p);
+    q->sel_ns += _now_ns() - t0;
+    q->sel_timed++;
+    return p;
+}
+
+
+Process* _MLFQ(Queue* q){
+    /* Returns the first process of the highest non-empty level (mlfq_top()). Profiled like _SJF() */
+    if(!q->prof || (q->sel_calls++ % SEL_SAMPLE) != 0){
+        int lvl = mlfq_top(q);
+        return (lvl < 0) ? NULL : q->lv[lvl].head->p;
+    }
+    long long t0 = _now_ns();
+    int lvl = mlfq_top(q);
+    Process *p = (lvl < 0) ? NULL : q->lv[lvl].head->p;
+    q->sel_ns += _now_ns() - t0;
+    q->sel_timed++;
+    return p;
+}
+
+
+Process* _LOTTERY(Queue* q, Rng* rng, long long* ticket){
+    /* Returns the winner of a draw among the tickets of a lottery queue, NULL if empty. Profiled like _SJF() */
+    if(q->cnt == 0){
+        return NULL;
+    }
+    if(!q->prof || (q->sel_calls++ % SEL_SAMPLE) != 0){
+        return _lottery_draw(q, rng, ticket);
+    }
+    long long t0 = _now_ns();
+    Process *p = _lottery_draw(q, rng, ticket);
+    q->sel_ns += _now_ns() - t0;
+    q->sel_timed++;
+    return p;
+}
+
+
+Process* _TOP(Queue* q){
+    /* Returns the top of a vruntime/deadline/pass heap (CFS, EDF, stride), NULL if empty. Profiled like _SJF() */
+    if(!q->prof || (q->sel_calls++ % SEL_SAMPLE) != 0){
+        return (q->cnt == 0) ? NULL : q->heap[0];
+    }
+    long long t0 = _now_ns();
+    Process *p = (q->cnt == 0) ? NULL : q->heap[0];
+    q->sel_ns += _now_ns() - t0;
+    q->sel_timed++;
+    return p;
+}
+
+
+static Process* _sjf_pick(Queue* q){
+    /* 
+    Returns the process with the shortest CPU burst time in the queue.
+    (heap queue: O(1) peek, key array: SIMD scan, otherwise O(n) scan)
+    */
+
+    // check if ready queue is empty
+    if(q->cnt == 0){
+        return NULL;
+    }
+    if(q->type == 1){
+        return q->heap[0];
+    }
+    if(q->type == 3){
+        return q->heap[argmin_key(q->key, q->kseq, q->cnt)];
+    }
+
+    Node* curr = q->head;   // not NULL
+    Node* min_node = q->head;  // not NULL
+
+    // seek ready queue
+    while(curr != NULL){
+        if(curr->p->cpu_burst_rem < min_node->p->cpu_burst_rem){    // schedule earlier process if same cpu_burst_rem
+            min_node = curr;
+        }
+        curr = curr->right;
+    } // curr == NULL
+
+    return min_node->p;
+}
+
+
+static Process* _prio_pick(Queue* q, Process* running_p){
+    /*
+    Priority Scheduling: Returns Process* with the highest priority
+    (heap queue: O(1) peek, key array: SIMD scan, otherwise O(n) scan)
+
+    
+    Process* running_p: currently running process
+    */
+
+    // check if ready queue is empty
+    if(q->cnt == 0){
+        return running_p;   // empty ready queue. Keep running_p. IDLE if running_p == NULL
+    }
+    
+    // max_priority = -1 if no running_p
+    int running_priority = (running_p == NULL) ? -1 : running_p->priority;
+    if(q->type == 2){   // heap: highest priority (earliest on ties) is on top
+        return (q->heap[0]->priority > running_priority) ? q->heap[0] : running_p;
+    }
+    if(q->type == 4){   // key array holds -priority: argmin is the highest priority
+        Process *top = q->heap[argmin_key(q->key, q->kseq, q->cnt)];
+        return (top->priority > running_priority) ? top : running_p;
+    }
+    int max_priority = running_priority;
+    Node* curr = q->head;
+    Node* max_node = q->head;
+
+    // seek ready queue
+    while(curr != NULL){
+        if(curr->p->priority > max_priority){
+            max_node = curr;
+            max_priority = curr->p->priority;
+        }
+        curr = curr->right;
+    }
+
+    // only preempt if ready queue has a Process with higher priority than running_p
+    return (max_priority > running_priority) ? max_node->p : running_p;
+}
+
+void print_process_info(Process* p){
+    // to be used after create_process()
+    printf("\n[%d] Process Info\n==============\n", p->pid);
+    switch (p->state) {
+        case 0:
+            printf("State: new\n");
+            break;
+        case 1:
+            printf("State: ready\n");
+            break;
+        case 2:
+            printf("State: running\n");
+            break;
+        case 3:
+            printf("State: waiting\n");
+            break;
+        case 4:
+            printf("State: terminated\n");
+            break;
+        default:
+            printf("State: unknown\n");
+            break;
+    }
+    printf("Arrival_time: %lld\n", p->arrival_time);
+    printf("Priority: %d\n", p->priority);
+    printf("CPU Burst Time (Initial): %d\n", p->cpu_burst_init);
+    printf("I/O Burst Time (Initial): %d\n", p->io_burst_rem);
+    printf("I/O Burst Start Time: %d\n", p->io_burst_start);
+    if(p->io_cnt > 1){
+        printf("I/O Bursts (after CPU clk, I/O clk, device):");
+        for(int i=0; i<p->io_cnt; i++){
+            printf(" (%d, %d, %d)", p->io_seq[i].gap, p->io_seq[i].len, p->io_seq[i].dev);
+        }
+        printf("\n");
+    }
+}
+
+
+void print_queue(Queue *q){
+    // check if empty
+    if(q->cnt == 0){
+        printf("Queue is empty\n");
+        return;
+    }
+    // print queue info
+    printf("Processes Count: %d\n", q->cnt);
+
+    if(q->type == 5){   // multi-level: level by level
+        for(int i=0; i<q->levels; i++){
+            printf("L%d: ", i);
+            for(Node *curr = q->lv[i].head; curr != NULL; curr = curr->right){
+                printf("[%d]-->", curr->p->pid);
+            }
+            printf("NULL\n");
+        }
+        printf("\n");
+        return;
+    }
+    if(q->type != 0){   // heap: array order
+        for(int i=0; i<q->cnt; i++){
+            printf("[%d]-->", q->heap[i]->pid);
+        }
+        printf("NULL\n\n");
+        return;
+    }
+    
+    // print queue
+    Node *curr = q->head;
+    while (curr != NULL) {
+        printf("[%d]-->", curr->p->pid);
+        curr = curr->right;
+    }
+    printf("NULL\n\n");
+}
+
+
+void compute_eval(Table* tbl, Eval* ev){
+    /*
+    Metrics of the terminated processes, read from the histograms filled as they terminated (no pass over term_q)
+    */
+    Stats *st = tbl->stats;
+    ev->num_process = (int)terminated(tbl);
+    ev->finish_clk = tbl->clk;
+    ev->ready_wait_sum = st->ready_wait.sum;
+    ev->io_wait_sum = st->io_wait.sum;
+    ev->turnaround_sum = st->turnaround.sum;
+    ev->response_sum = st->response.sum;
+    hist_dist(&st->turnaround, &ev->turnaround);
+    hist_dist(&st->ready_wait, &ev->ready_wait);
+    hist_dist(&st->io_wait, &ev->io_wait);
+    hist_dist(&st->response, &ev->response);
+    ev->wait_sum = ev->ready_wait_sum + ev->io_wait_sum;
+    ev->segments = tbl->gannt.cnt;
+    ev->num_cores = tbl->num_cores;
+    ev->num_devices = tbl->io->num_devices;
+    ev->io_bursts = tbl->io->completed;
+    ev->migrations = tbl->migrations;
+    ev->dispatches = tbl->dispatches;
+    ev->select_calls = tbl->ready_q->sel_calls;
+    long long timed = tbl->ready_q->sel_timed, timed_ns = tbl->ready_q->sel_ns;
+    long long busy_sum = tbl->gannt.busy;
+    ev->imbalance = 0.0;
+    if(tbl->cores != NULL){
+        long long busy_max = 0;
+        busy_sum = 0;
+        for(int i=0; i<tbl->num_cores; i++){
+            Timeline *tl = &tbl->cores[i]->gannt;
+            long long busy = tl->busy;
+            busy_sum += busy;
+            busy_max = (busy > busy_max) ? busy : busy_max;
+            ev->segments += tl->cnt;
+            ev->dispatches += tbl->cores[i]->dispatches;
+            ev->select_calls += tbl->cores[i]->ready_q->sel_calls;
+            timed += tbl->cores[i]->ready_q->sel_timed;
+            timed_ns += tbl->cores[i]->ready_q->sel_ns;
+        }
+        if(busy_sum > 0){
+            ev->imbalance = (double)busy_max * tbl->num_cores / busy_sum - 1.0;
+        }
+    }
+    ev->select_ns = (timed > 0) ? (double)timed_ns / timed : 0.0;
+    ev->utilization = (tbl->clk > 0) ? (double)busy_sum / ((double)tbl->clk * tbl->num_cores) : 0.0;
+    ev->deadline_jobs = st->deadline_jobs;
+    ev->deadline_misses = st->lateness.n;
+    ev->lateness_avg = (st->deadline_jobs > 0) ? (double)st->lateness_sum / st->deadline_jobs : 0.0;
+    hist_dist(&st->lateness, &ev->lateness);
+    ev->share_dev_avg = (st->share_dev.n > 0) ? (double)st->share_dev.sum / st->share_dev.n / 1000 : 0.0;
+    hist_dist(&st->share_dev, &ev->share_dev);
+    ev->fairness = (st->share_sq > 0) ? st->share_sum * st->share_sum / (st->share_sq * ev->num_process) : 0.0;
+    for(int i=0; i<MAX_PRIORITY; i++){
+        ev->prio_share[i] = (st->prio_cnt[i] > 0) ? st->prio_share[i] / st->prio_cnt[i] : 0.0;
+    }
+}
+
+
+void evaluate(Table* tbl, int algo){
+    /*
+    Display evaluation info/metrics for the process in term_q
+    with the provided `pid`
+    if pid=0, it will display overview
+    if pid=-1, it will exit evaluation mode
+     */
+    int pid;
+    Queue* term_q = tbl->term_q;
+
+    printf("\n\n====START EVALUATION====\n");
+    // take user input for pid
+    while(pid != -1){
+        printf("<<Enter PID to evaluate (0: overview, -1: restart, -2: exit)>>\n");
+        printf("PID: ");
+        scanf(" %d", &pid); // consume newline
+        printf("--------------------------------------\n");
+        Node* curr = term_q->head;
+        if(pid == -1){
+            printf("\nExiting evaluation...\n");
+            break;
+        }
+        else if(pid == -2){
+            printf("\nExiting program...\n");
+            exit(0);
+        }
+        if(pid==0){ // overview
+            Eval ev;
+            compute_eval(tbl, &ev);
+            long long ready_wait_time_sum = ev.ready_wait_sum;
+            long long io_wait_time_sum = ev.io_wait_sum;
+            long long turnaround_time_sum = ev.turnaround_sum;
+            long long wait_time_sum = ev.wait_sum;
+
+            long long ready_wait_time_avg = 0;
+            long long io_wait_time_avg = 0;
+            long long turnaround_time_avg = 0;
+            long long wait_time_avg = 0;
+            int num_process = ev.num_process;
+
+            ready_wait_time_avg = ready_wait_time_sum / num_process;
+            io_wait_time_avg = io_wait_time_sum / num_process;
+            turnaround_time_avg = turnaround_time_sum / num_process;
+            wait_time_avg = wait_time_sum / num_process;
+            printf("Algorithm: %s\n", _algo_name(algo, true));
+            printf("Task Finished at %lld\n\n", tbl->clk);
+            printf("Terminated Queue:\n");
+            print_queue(term_q);
+            printf("\nWait time: total=%lld, avg=%lld\n", wait_time_sum, wait_time_avg);
+            printf("Ready queue wait time: total=%lld, avg=%lld\n", ready_wait_time_sum, ready_wait_time_avg);
+            printf("Wait queue wait time: total=%lld, avg=%lld\n", io_wait_time_sum, io_wait_time_avg);
+            printf("Turnaround time: total=%lld, avg=%lld\n", turnaround_time_sum, turnaround_time_avg);
+            printf("Response time: total=%lld, avg=%lld\n", ev.response_sum, ev.response_sum / num_process);
+            printf("Turnaround p50/p95/p99/max: %lld/%lld/%lld/%lld\n", ev.turnaround.p50, ev.turnaround.p95, ev.turnaround.p99, ev.turnaround.max);
+            printf("Ready wait p50/p95/p99/max: %lld/%lld/%lld/%lld\n", ev.ready_wait.p50, ev.ready_wait.p95, ev.ready_wait.p99, ev.ready_wait.max);
+            printf("I/O wait   p50/p95/p99/max: %lld/%lld/%lld/%lld\n", ev.io_wait.p50, ev.io_wait.p95, ev.io_wait.p99, ev.io_wait.max);
+            printf("Response   p50/p95/p99/max: %lld/%lld/%lld/%lld\n", ev.response.p50, ev.response.p95, ev.response.p99, ev.response.max);
+            // fairness: the CPU share a process got of the time it was ready, against the weight of its priority
+            for(int i=0; i<MAX_PRIORITY; i++){
+                if(tbl->stats->prio_cnt[i] > 0){
+                    printf("Priority %d (weight %d): %lld processes, CPU share avg=%.3f (%.3f per %d weight)\n",
+                           i+1, cfs_weight(i+1), tbl->stats->prio_cnt[i], ev.prio_share[i],
+                           ev.prio_share[i] * CFS_WEIGHT_0 / cfs_weight(i+1), CFS_WEIGHT_0);
+                }
+            }
+            printf("Fairness (Jain index of CPU share / weight): %.4f\n", ev.fairness);
+            printf("CPU utilization: %.3f\n", ev.utilization);
+            if(ev.deadline_jobs > 0){
+                printf("Deadlines: %lld of %lld missed (%.2f%%), lateness avg=%.2f\n", ev.deadline_misses, ev.deadline_jobs,
+                       100.0 * ev.deadline_misses / ev.deadline_jobs, ev.lateness_avg);
+                printf("Lateness of misses p50/p95/p99/max: %lld/%lld/%lld/%lld\n",
+                       ev.lateness.p50, ev.lateness.p95, ev.lateness.p99, ev.lateness.max);
+            }
+            if(tbl->stats->share_dev.n > 0){
+                // proportional share: CPU received against the share its tickets entitled it to while runnable
+                printf("CPU vs entitled share (|CPU/entitled - 1|): avg=%.3f, p50/p95/p99/max: %.3f/%.3f/%.3f/%.3f\n",
+                       ev.share_dev_avg, ev.share_dev.p50/1000.0, ev.share_dev.p95/1000.0,
+                       ev.share_dev.p99/1000.0, ev.share_dev.max/1000.0);
+            }
+            printf("\n\n");
+            for(int i=0; tbl->io->num_devices > 1 && i<tbl->io->num_devices; i++){
+                printf("I/O device %d: busy=%lld clk\n", i, tbl->io->dev[i].busy);
+            }
+            printf("Allocations while simulating: total=%lld, per clk=%.4f (last at clk %lld)\n\n",
+                   tbl->allocs, (tbl->clk > 0) ? (double)tbl->allocs/tbl->clk : 0.0, tbl->alloc_clk);
+
+            print_core_stats(tbl);
+        }
+        else{ // pid != 0
+            while(curr != NULL){    // search term_q for PID match
+                if(curr->p->pid == pid){
+                    printf("[%d] Evaluation\n", pid);
+                    printf("--------------------\n");
+                    printf("Wait time: %lld (ready: %lld, wait:%lld)\n",
+                    curr->p->ready_wait_time + curr->p->io_wait_time, curr->p->ready_wait_time, curr->p->io_wait_time);
+                    printf("Turnaround time: %lld (Arrive:%lld, Terminate:%lld)\n",
+                    curr->p->turnaround_time, curr->p->arrival_time, curr->p->finish_time);
+                    printf("Response time: %lld (First run:%lld)\n",
+                    curr->p->first_run - curr->p->arrival_time, curr->p->first_run);
+                    if(curr->p->tickets > 0){
+                        printf("Tickets: %d (CPU: %d clk, entitled to %.1f clk)\n",
+                        curr->p->tickets, curr->p->cpu_burst_init, curr->p->entitled);
+                    }
+                    if(curr->p->deadline > 0){
+                        printf("Deadline: %lld (lateness: %lld)\n", curr->p->arrival_time + curr->p->deadline,
+                        curr->p->finish_time + 1 - (curr->p->arrival_time + curr->p->deadline));
+                    }
+                    printf("Priority: %d\n\n\n", curr->p->priority);
+                    break;  // break out of while(curr != NULL)
+                }
+                curr = curr->right;
+            }
+            if(curr == NULL){
+                printf("Error: PID not found\n\n\n");
+            }
+        } // else: display evaluation info for process with pid
+    }
+}
+
+
+void gannt_record(Timeline* tl, long long clk, long long ticks, int pid){
+    /*
+    Record that `pid` (-1: idle) was on the CPU for `ticks` clks starting at `clk`.
+    Extends the last Segment if it continues it, so memory grows with context switches, not with time.
+    With tl->tail_only (batch runs) only the last Segment is kept and memory does not grow at all.
+    */
+    if(ticks <= 0){
+        return;
+    }
+    if(pid != -1){
+        tl->busy += ticks;
+    }
+    if(tl->cnt > 0){
+        Segment *last = &tl->seg[tl->tail_only ? 0 : tl->cnt-1];
+        if(last->pid == pid && last->end == clk){
+            last->end += ticks;
+            return;
+        }
+        if(tl->out != NULL && last->pid != -1){
+            // the last segment is over
+            timeline_rec(tl->out, TL_CPU, tl->track, last->start, last->end - last->start, last->pid, 0);
+        }
+    }
+    if(tl->tail_only){
+        if(tl->cap == 0){
+            tl->cap = 1;
+            tl->seg = (Segment*)malloc(sizeof(Segment));
+        }
+        tl->seg[0].start = clk;
+        tl->seg[0].end = clk + ticks;
+        tl->seg[0].pid = pid;
+        tl->cnt++;
+        return;
+    }
+    if(tl->cnt == tl->cap){
+        tl->cap = (tl->cap == 0) ? 64 : tl->cap*2;
+        tl->seg = (Segment*)realloc(tl->seg, sizeof(Segment)*tl->cap);
+    }
+    tl->seg[tl->cnt].start = clk;
+    tl->seg[tl->cnt].end = clk + ticks;
+    tl->seg[tl->cnt].pid = pid;
+    tl->cnt++;
+}
+
+
+void print_gannt_chart(Timeline* tl){
+    
+    printf("====Gannt Chart====\n");
+    printf("(CPU burst starts this clock)---[Process]---(next Process starts this clock)\n\n");
+
+    if(tl->cnt == 0){
+        printf("(empty)\n\n");
+        return;
+    }
+
+    // gannt chart
+    printf("(0)");
+    for(int i=0; i<tl->cnt-1; i++){
+        if(tl->seg[i].pid == -1){
+            printf("---CPU IDLE---(%lld)", tl->seg[i].end);
+        }
+        else{
+            printf("---[PID: %d]---(%lld)", tl->seg[i].pid, tl->seg[i].end);
+        }
+    }
+    // finish clock
+    Segment *last = &tl->seg[tl->cnt-1];
+    if(last->pid == -1){    // a core that ran out of work before the others
+        printf("---CPU IDLE---(%lld)", last->end-1);
+    }
+    else{
+        printf("---[PID: %d]---(%lld)", last->pid, last->end-1);
+    }
+    printf("\n\n");
+}
+
+
+void print_core_stats(Table* tbl){
+    /*
+    Per-core gannt charts and utilization (multi-core only)
+    */
+    if(tbl->cores == NULL){
+        print_gannt_chart(&tbl->gannt);
+        return;
+    }
+    for(int i=0; i<tbl->num_cores; i++){
+        Timeline *tl = &tbl->cores[i]->gannt;
+        printf("<<Core %d>> busy=%lld clk (%.1f%%), segments=%d\n",
+               i, tl->busy, 100.0*tl->busy/(tbl->clk+1), tl->cnt);
+        print_gannt_chart(tl);
+    }
+    Eval ev;
+    compute_eval(tbl, &ev);
+    printf("Migrations: %lld, load imbalance: %.3f\n\n", ev.migrations, ev.imbalance);
+}
+
+
+void print_summary(Config* cfg, Eval* ev, double wall_sec, bool header){
+    /*
+    Machine-readable summary of a batch run (Config.format: 0: text, 1: json, 2: csv)
+    */
+    const char* algo_name = _algo_name(cfg->algo, false);
+    int n = (ev->num_process > 0) ? ev->num_process : 1;
+    double tps = (wall_sec > 0) ? ev->finish_clk / wall_sec : 0.0;
+    const char* dist_names[] = {"turnaround", "ready_wait", "io_wait", "response"};
+    Dist* dist[] = {&ev->turnaround, &ev->ready_wait, &ev->io_wait, &ev->response};
+
+    switch(cfg->format){
+        case 1: // json
+            printf("{\"algo\":\"%s\",\"quantum\":%d,\"num_process\":%d,\"seed\":%d,\"engine\":\"%s\","
+                   "\"terminated\":%d,\"finish_clk\":%lld,\"segments\":%d,"
+                   "\"wait_total\":%lld,\"wait_avg\":%.3f,\"ready_wait_total\":%lld,\"ready_wait_avg\":%.3f,"
+                   "\"io_wait_total\":%lld,\"io_wait_avg\":%.3f,\"turnaround_total\":%lld,\"turnaround_avg\":%.3f,"
+                   "\"cores\":%d,\"migrations\":%lld,\"imbalance\":%.3f,\"devices\":%d,\"io_bursts\":%lld,"
+                   "\"response_total\":%lld,\"response_avg\":%.3f,",
+                   algo_name, cfg->quantum, cfg->num_process, cfg->seed, (cfg->engine == 1) ? "event" : "tick",
+                   ev->num_process, ev->finish_clk, ev->segments,
+                   ev->wait_sum, (double)ev->wait_sum/n, ev->ready_wait_sum, (double)ev->ready_wait_sum/n,
+                   ev->io_wait_sum, (double)ev->io_wait_sum/n, ev->turnaround_sum, (double)ev->turnaround_sum/n,
+                   ev->num_cores, ev->migrations, ev->imbalance, ev->num_devices, ev->io_bursts,
+                   ev->response_sum, (double)ev->response_sum/n);
+            for(int i=0; i<4; i++){
+                printf("\"%s_p50\":%lld,\"%s_p95\":%lld,\"%s_p99\":%lld,\"%s_max\":%lld,",
+                       dist_names[i], dist[i]->p50, dist_names[i], dist[i]->p95, dist_names[i], dist[i]->p99, dist_names[i], dist[i]->max);
+            }
+            printf("\"fairness\":%.4f,\"utilization\":%.4f,\"deadline_jobs\":%lld,\"deadline_misses\":%lld,\"lateness_avg\":%.3f,"
+                   "\"lateness_p50\":%lld,\"lateness_p95\":%lld,\"lateness_p99\":%lld,\"lateness_max\":%lld,",
+                   ev->fairness, ev->utilization, ev->deadline_jobs, ev->deadline_misses, ev->lateness_avg,
+                   ev->lateness.p50, ev->lateness.p95, ev->lateness.p99, ev->lateness.max);
+            printf("\"share_dev_avg\":%.4f,\"share_dev_p50\":%.3f,\"share_dev_p95\":%.3f,\"share_dev_max\":%.3f,",
+                   ev->share_dev_avg, ev->share_dev.p50/1000.0, ev->share_dev.p95/1000.0, ev->share_dev.max/1000.0);
+            printf("\"wall_sec\":%.6f,\"ticks_per_sec\":%.1f}\n", wall_sec, tps);
+            break;
+        case 2: // csv
+            if(header){
+                printf("algo,quantum,num_process,seed,engine,terminated,finish_clk,segments,"
+                       "wait_total,wait_avg,ready_wait_total,ready_wait_avg,io_wait_total,io_wait_avg,"
+                       "turnaround_total,turnaround_avg,cores,migrations,imbalance,devices,io_bursts,response_total,response_avg,");
+                for(int i=0; i<4; i++){
+                    printf("%s_p50,%s_p95,%s_p99,%s_max,", dist_names[i], dist_names[i], dist_names[i], dist_names[i]);
+                }
+                printf("fairness,utilization,deadline_jobs,deadline_misses,lateness_avg,"
+                       "lateness_p50,lateness_p95,lateness_p99,lateness_max,share_dev_avg,share_dev_p50,share_dev_p95,share_dev_max,"
+                       "wall_sec,ticks_per_sec\n");
+            }
+            printf("%s,%d,%d,%d,%s,%d,%lld,%d,%lld,%.3f,%lld,%.3f,%lld,%.3f,%lld,%.3f,%d,%lld,%.3f,%d,%lld,%lld,%.3f,",
+                   algo_name, cfg->quantum, cfg->num_process, cfg->seed, (cfg->engine == 1) ? "event" : "tick",
+                   ev->num_process, ev->finish_clk, ev->segments,
+                   ev->wait_sum, (double)ev->wait_sum/n, ev->ready_wait_sum, (double)ev->ready_wait_sum/n,
+                   ev->io_wait_sum, (double)ev->io_wait_sum/n, ev->turnaround_sum, (double)ev->turnaround_sum/n,
+                   ev->num_cores, ev->migrations, ev->imbalance, ev->num_devices, ev->io_bursts,
+                   ev->response_sum, (double)ev->response_sum/n);
+            for(int i=0; i<4; i++){
+                printf("%lld,%lld,%lld,%lld,", dist[i]->p50, dist[i]->p95, dist[i]->p99, dist[i]->max);
+            }
+            printf("%.4f,%.4f,%lld,%lld,%.3f,%lld,%lld,%lld,%lld,", ev->fairness, ev->utilization,
+                   ev->deadline_jobs, ev->deadline_misses, ev->lateness_avg,
+                   ev->lateness.p50, ev->lateness.p95, ev->lateness.p99, ev->lateness.max);
+            printf("%.4f,%.3f,%.3f,%.3f,%.6f,%.1f\n", ev->share_dev_avg,
+                   ev->share_dev.p50/1000.0, ev->share_dev.p95/1000.0, ev->share_dev.max/1000.0, wall_sec, tps);
+            break;
+        default: // text
+            printf("Algorithm: %s (quantum=%d), processes: %d, seed: %d, engine: %s\n",
+                   algo_name, cfg->quantum, cfg->num_process, cfg->seed, (cfg->engine == 1) ? "event" : "tick");
+            printf("Terminated: %d, finished at %lld, gannt segments: %d\n", ev->num_process, ev->finish_clk, ev->segments);
+            printf("Wait time: total=%lld, avg=%.3f\n", ev->wait_sum, (double)ev->wait_sum/n);
+            printf("Ready queue wait time: total=%lld, avg=%.3f\n", ev->ready_wait_sum, (double)ev->ready_wait_sum/n);
+            printf("Wait queue wait time: total=%lld, avg=%.3f\n", ev->io_wait_sum, (double)ev->io_wait_sum/n);
+            printf("Turnaround time: total=%lld, avg=%.3f\n", ev->turnaround_sum, (double)ev->turnaround_sum/n);
+            printf("Response time: total=%lld, avg=%.3f\n", ev->response_sum, (double)ev->response_sum/n);
+            for(int i=0; i<4; i++){
+                printf("%-11s p50=%lld, p95=%lld, p99=%lld, max=%lld\n",
+                       dist_names[i], dist[i]->p50, dist[i]->p95, dist[i]->p99, dist[i]->max);
+            }
+            printf("Fairness (Jain index of CPU share / weight): %.4f\n", ev->fairness);
+            printf("CPU utilization: %.3f\n", ev->utilization);
+            if(ev->deadline_jobs > 0){
+                printf("Deadlines: %lld of %lld missed, lateness avg=%.3f, misses p50=%lld, p95=%lld, p99=%lld, max=%lld\n",
+                       ev->deadline_misses, ev->deadline_jobs, ev->lateness_avg,
+                       ev->lateness.p50, ev->lateness.p95, ev->lateness.p99, ev->lateness.max);
+            }
+            if(cfg->algo == 9 || cfg->algo == 10){
+                printf("CPU vs entitled share: avg deviation=%.4f, p50=%.3f, p95=%.3f, max=%.3f\n", ev->share_dev_avg,
+                       ev->share_dev.p50/1000.0, ev->share_dev.p95/1000.0, ev->share_dev.max/1000.0);
+            }
+            if(ev->num_cores > 1){
+                printf("Cores: %d, migrations: %lld, load imbalance: %.3f\n", ev->num_cores, ev->migrations, ev->imbalance);
+            }
+            if(ev->num_devices > 1 || ev->io_bursts > ev->num_process){
+                printf("I/O devices: %d, I/O bursts: %lld\n", ev->num_devices, ev->io_bursts);
+            }
+            printf("Simulated %lld clk in %.6f sec (%.1f clk/sec)\n", ev->finish_clk, wall_sec, tps);
+            break;
+    }
+}
+
+
+static void _print_algos(const char* indent, const char* end){
+    /* "0: FCFS, 1: SJF, ..." (POLICIES labels), 6 to a line, lines after the first start with `indent` */
+    for(int a=0; a<=MAX_ALGO; a++){
+        printf("%d: %s%s", a, _algo_name(a, false), (a == MAX_ALGO) ? end : (a % 6 == 5) ? ",\n" : ", ");
+        if(a % 6 == 5 && a < MAX_ALGO){
+            printf("%s", indent);
+        }
+    }
+}
+
+
+void display_config(Config* cfg){
+    /* prints Config */
+    printf("\n\n==============\n");
+    printf("<<Config>>\n");
+    printf("==============\n");
+    printf("Number of processes: %d\n", cfg->num_process);
+    printf("Scheduling algorithm: %s\n", _algo_name(cfg->algo, true));
+    switch (cfg->algo) {
+        case 5:
+            printf("Time quantum: %d\n", cfg->quantum);
+            break;
+        case 6:
+            printf("Levels: %d, quanta:", cfg->mlfq_levels);
+            for(int i=0, q=cfg->quantum; i<cfg->mlfq_levels; i++, q*=2){
+                q = (cfg->mlfq_quanta[i] > 0) ? cfg->mlfq_quanta[i] : q;
+                printf(" %d", q);
+            }
+            printf(", boost: every %d clk\n", cfg->mlfq_boost);
+            break;
+        case 7:
+            printf("Minimum granularity: %d, wake-up credit: %d clk\n", cfg->quantum, cfg->cfs_latency/2);
+            break;
+        case 8:
+            if(cfg->num_tasks > 0){
+                printf("Periodic task set: %d tasks, utilization %.2f, deadline %.2f x period\n",
+                       cfg->num_tasks, cfg->task_util, cfg->task_deadline);
+            }
+            else{
+                printf("Deadline: %.2f x CPU burst\n", cfg->deadline_factor);
+            }
+            break;
+        case 9:
+        case 10:
+            printf("Time quantum: %d, tickets of priorities 1~%d:", cfg->quantum, MAX_PRIORITY);
+            for(int i=0; i<MAX_PRIORITY; i++){
+                printf(" %d", (cfg->tickets[i] > 0) ? cfg->tickets[i] : cfs_weight(i+1));
+            }
+            printf("\n");
+            break;
+    }
+    const char* ready_q_names[] = {"linked list", "heap", "key array (SIMD)"};
+    printf("Ready queue: %s\n", (_policy_queue(cfg->algo) == 1 || _policy_queue(cfg->algo) == 2) ? ready_q_names[cfg->ready_q_type] : "linked list");
+    printf("Engine: %s\n", (cfg->engine == 1) ? "event-driven" : "tick");
+    printf("Cores: %d\n", cfg->num_cores);
+    printf("I/O devices: %d, I/O bursts per process: up to %d\n", cfg->num_devices, cfg->io_bursts);
+    printf("\n\n");
+}
+
+
+void edit_config(Config* cfg){
+    display_config(cfg);
+    printf("\n\n<<Edit Config?>> (y/n) : ");
+    char c;
+    scanf(" %c", &c);
+
+    if(c == 'y'){
+        printf("\n<<Edit Config>>\n\n");
+        printf("<<Enter number of processes>>: ");
+        scanf(" %d", &cfg->num_process);
+        printf("\n<<Enter scheduling algorithm>> (0~%d)\n", MAX_ALGO);
+        _print_algos("", "\n");
+        printf("Algorithm: ");
+        scanf(" %d", &cfg->algo);
+        if(_uses_quantum(cfg->algo)){
+            printf((cfg->algo == 7) ? "<<Enter minimum granularity>> (default=5): " : "<<Enter time quantum>> (default=5): ");
+            scanf(" %d", &cfg->quantum);
+        }
+        if(cfg->algo == 6){
+            printf("<<Enter number of levels>> (default=3, quantum doubles at every level): ");
+            scanf(" %d", &cfg->mlfq_levels);
+            cfg->mlfq_levels = (cfg->mlfq_levels < 1) ? 1 : (cfg->mlfq_levels > MLFQ_MAX_LEVELS) ? MLFQ_MAX_LEVELS : cfg->mlfq_levels;
+            printf("<<Enter priority boost period>> (default=100, 0: never): ");
+            scanf(" %d", &cfg->mlfq_boost);
+            cfg->mlfq_boost = (cfg->mlfq_boost < 0) ? 0 : cfg->mlfq_boost;
+        }
+        if(cfg->algo == 8){
+            printf("<<Enter relative deadline>> (x CPU burst, default=3): ");
+            scanf(" %lf", &cfg->deadline_factor);
+            cfg->deadline_factor = (cfg->deadline_factor < 0) ? 0 : cfg->deadline_factor;
+        }
+        // use priority?
+        cfg->use_priority = _uses_priority(cfg->algo);
+        // random seed?
+        printf("\n<<Use random seed?>> (y/n): ");
+        scanf(" %c", &c);
+        if(c == 'y'){
+            printf("\n<<Enter random seed>> (int 1~99): ");
+            scanf(" %d", &cfg->seed);
+        }
+        // simulation engine
+        printf("\n<<Use event-driven engine?>> (y/n): ");
+        scanf(" %c", &c);
+        cfg->engine = (c == 'y') ? 1 : 0;
+        // number of cores
+        printf("\n<<Enter number of cores>> (default=1): ");
+        scanf(" %d", &cfg->num_cores);
+        if(cfg->num_cores < 1){
+            cfg->num_cores = 1;
+        }
+        if(cfg->num_cores > 1){
+            cfg->engine = 0;    // the event engine models one CPU
+        }
+        // I/O
+        printf("\n<<Enter number of I/O devices>> (default=1): ");
+        scanf(" %d", &cfg->num_devices);
+        printf("\n<<Enter maximum number of I/O bursts per process>> (default=1): ");
+        scanf(" %d", &cfg->io_bursts);
+        cfg->num_devices = (cfg->num_devices < 1) ? 1 : cfg->num_devices;
+        cfg->io_bursts = (cfg->io_bursts < 1) ? 1 : cfg->io_bursts;
+        printf("\n<<Config updated>>\n");
+        display_config(cfg);
+    }
+    else{
+        printf("\n\n<<Using default config>>\n");
+    }
+}
+
+
+ALWAYS_INLINE void _run_tick_loop(Table* tbl, Config* cfg, const int algo){
+    /*
+    Simulate one clock cycle at a time until every process is terminated (or cfg->max_time)
+    */
+    while(cfg->max_time == 0 || tbl->clk < cfg->max_time){
+        if(cfg->interactive && tbl->clk % 20 == 0){
+            printf("\nDue to Ubuntu Server terminal's scroll constraint, only 20 cycles of log will be displayed at a time.\n");
+            printf("Input any character to continue...\n");
+            char c;
+            scanf(" %c", &c);
+            printf("\n\n");
+        }
+        // add processes that arrived to ready_queue
+        arrived_to_ready(tbl, cfg->num_process);
+        _wait_to_ready(tbl, algo);
+        // schedule, compute, enqueue, dequeue processes
+        io_service(tbl, algo);
+        share_clock(tbl->stats, 1, 1);
+        _cpu(tbl, algo, cfg->quantum);
+        if(tbl->tl_out != NULL){
+            timeline_counters(tbl);
+        }
+
+        // check if all processes are terminated
+        if(terminated(tbl) == cfg->num_process){
+            LOG_EVENT(tbl, tbl->clk, LOG_COMPLETE, 0, 0, 0, 0, 0, 0);
+            break;
+        }
+
+        track_allocs(tbl, NULL);
+
+        tbl->clk++;
+    }
+}
+
+
+ALWAYS_INLINE void _run_event_loop(Table* tbl, Config* cfg, const int algo){
+    /*
+    Discrete-event version of run_tick(): only the clk values at which something can change are simulated.
+    Every other clk is applied in bulk by fast_forward(), so the cost follows the number of
+    scheduling events instead of the simulated time span. Results are identical to run_tick().
+    */
+    EventQueue *eq = create_event_queue(16);
+
+    long long last_pause = -20;
+    while(cfg->max_time == 0 || tbl->clk < cfg->max_time){
+        if(cfg->interactive && tbl->clk - last_pause >= 20){
+            printf("\nDue to Ubuntu Server terminal's scroll constraint, only 20 cycles of log will be displayed at a time.\n");
+            printf("Input any character to continue...\n");
+            char c;
+            scanf(" %c", &c);
+            printf("\n\n");
+            last_pause = tbl->clk;
+        }
+        // simulate the event clk exactly like the tick loop
+        arrived_to_ready(tbl, cfg->num_process);
+        _wait_to_ready(tbl, algo);
+        io_service(tbl, algo);
+        share_clock(tbl->stats, 1, 1);
+        _cpu(tbl, algo, cfg->quantum);
+        if(tbl->tl_out != NULL){
+            timeline_counters(tbl);
+        }
+
+        if(terminated(tbl) == cfg->num_process){
+            LOG_EVENT(tbl, tbl->clk, LOG_COMPLETE, 0, 0, 0, 0, 0, 0);
+            break;
+        }
+
+        // jump to the next event (next arrival comes from the new_pool cursor)
+        Process *p = peek_arrival(tbl);
+        if(p != NULL){
+            push_event(eq, p->arrival_time, 0, p->pid);
+        }
+        _schedule_events(tbl, eq, algo);
+        track_allocs(tbl, eq);
+        long long next = next_event_time(tbl, eq);
+        if(next < 0){
+            printf("<@%lld> ERROR: no more events but processes are not terminated\n", tbl->clk);
+            exit(1);
+        }
+        if(cfg->max_time != 0 && next > cfg->max_time){
+            next = cfg->max_time;
+        }
+        _fast_forward(tbl, algo, next - tbl->clk - 1);
+        tbl->clk = next;
+    }
+    free(eq->heap);
+    free(eq);
+}
+
+
+ALWAYS_INLINE void _run_multi_loop(Table* tbl, Config* cfg, const int algo){
+    /*
+    Multi-core tick loop: every clk, route arrivals and finished I/O to the cores,
+    service the (shared) I/O device, then let every core steal if it is idle and run CPU() on its own Table
+    */
+    while(cfg->max_time == 0 || tbl->clk < cfg->max_time){
+        if(cfg->interactive && tbl->clk % 20 == 0){
+            printf("\nDue to Ubuntu Server terminal's scroll constraint, only 20 cycles of log will be displayed at a time.\n");
+            printf("Input any character to continue...\n");
+            char c;
+            scanf(" %c", &c);
+            printf("\n\n");
+        }
+        for(int i=0; i<tbl->num_cores; i++){
+            tbl->cores[i]->clk = tbl->clk;
+        }
+        arrived_to_cores(tbl, cfg->num_process);
+        io_to_core(tbl);
+        io_service(tbl, algo);
+        share_clock(tbl->stats, tbl->num_cores, 1);
+        for(int i=0; i<tbl->num_cores; i++){
+            steal_work(tbl, tbl->cores[i], algo);
+            _cpu(tbl->cores[i], algo, cfg->quantum);
+        }
+        if(tbl->tl_out != NULL){
+            timeline_counters(tbl);
+        }
+
+        if(terminated(tbl) == cfg->num_process){
+            LOG_EVENT(tbl, tbl->clk, LOG_COMPLETE, 0, 0, 0, 0, 0, 0);
+            break;
+        }
+
+        track_allocs(tbl, NULL);
+
+        tbl->clk++;
+    }
+}
+
+
+// one copy of each loop per policy: _run_tick_fcfs(), _run_event_fcfs(), _run_multi_fcfs(), ...
+#define X(id, name, label, title, charge, timers, preempt, prio, quantum, queue) \
+    static void _run_tick_##name(Table* tbl, Config* cfg){_run_tick_loop(tbl, cfg, id);} \
+    static void _run_event_##name(Table* tbl, Config* cfg){_run_event_loop(tbl, cfg, id);} \
+    static void _run_multi_##name(Table* tbl, Config* cfg){_run_multi_loop(tbl, cfg, id);}
+POLICIES(X)
+#undef X
+
+typedef void (*RunLoop)(Table* tbl, Config* cfg);
+#define X(id, name, label, title, charge, timers, preempt, prio, quantum, queue) [id] = _run_tick_##name,
+static const RunLoop _tick_loops[MAX_ALGO+1] = {POLICIES(X)};
+#undef X
+#define X(id, name, label, title, charge, timers, preempt, prio, quantum, queue) [id] = _run_event_##name,
+static const RunLoop _event_loops[MAX_ALGO+1] = {POLICIES(X)};
+#undef X
+#define X(id, name, label, title, charge, timers, preempt, prio, quantum, queue) [id] = _run_multi_##name,
+static const RunLoop _multi_loops[MAX_ALGO+1] = {POLICIES(X)};
+#undef X
+
+
+void run_tick(Table* tbl, Config* cfg){
+    /*
+    Tick loop specialized for cfg->algo (cfg->generic_loop: one loop that tests algo every clk, as a baseline)
+    */
+    if(cfg->generic_loop || _tick_loops[cfg->algo] == NULL){
+        _run_tick_loop(tbl, cfg, cfg->algo);
+        return;
+    }
+    _tick_loops[cfg->algo](tbl, cfg);
+}
+
+
+void run_event(Table* tbl, Config* cfg){
+    /*
+    Event loop specialized for cfg->algo (cfg->generic_loop: one loop that tests algo at every event)
+    */
+    if(cfg->generic_loop || _event_loops[cfg->algo] == NULL){
+        _run_event_loop(tbl, cfg, cfg->algo);
+        return;
+    }
+    _event_loops[cfg->algo](tbl, cfg);
+}
+
+
+void run_multi(Table* tbl, Config* cfg){
+    /*
+    Multi-core tick loop specialized for cfg->algo (cfg->generic_loop: one loop that tests algo on every core and clk)
+    */
+    if(cfg->generic_loop || _multi_loops[cfg->algo] == NULL){
+        _run_multi_loop(tbl, cfg, cfg->algo);
+        return;
+    }
+    _multi_loops[cfg->algo](tbl, cfg);
+}
+
+
+static void _batch_usage(){
+    printf("usage: cpu_scheduler [options]   (no options: interactive mode)\n");
+    printf("  -a, --algo N        ");
+    _print_algos("                      ", " (default 5)\n");
+    printf("  -q, --quantum N     time quantum for RR/lottery/stride and of the top MLFQ level, CFS minimum granularity\n");
+    printf("                      (default 5)\n");
+    printf("      --levels N      MLFQ levels, up to %d (default 3)\n", MLFQ_MAX_LEVELS);
+    printf("      --level-quanta L    MLFQ quantum of each level, e.g. 2,4,8 (default: doubles at every level)\n");
+    printf("      --boost N       MLFQ: every process back to the top level every N clk (default 100, 0: never)\n");
+    printf("      --latency N     CFS: a process waking up is placed up to N/2 clk behind the others (default 12)\n");
+    printf("      --deadline X    relative deadline of every process: X times its CPU burst (default 0: none)\n");
+    printf("      --tasks N       the processes are the jobs of N periodic tasks, up to %d (periods 10~1000, no I/O)\n", MAX_TASKS);
+    printf("      --utilization U     total utilization of the task set (default 0.8)\n");
+    printf("      --task-deadline X   relative deadline of the tasks: X times the period (default 1)\n");
+    printf("      --tickets L     lottery/stride: tickets of priorities 1~%d, e.g. 1,2,4,8 (default: CFS weights)\n", MAX_PRIORITY);
+    printf("      --admit         EDF admission test of the task set first, exit 3 if it is not schedulable\n");
+    printf("  -n, --num N         number of processes (default 5)\n");
+    printf("  -s, --seed N        random seed (default 98)\n");
+    printf("  -f, --format F      summary format: text, json, csv (default text)\n");
+    printf("  -e, --engine E      tick or event (default tick)\n");
+    printf("  -t, --max-time N    stop at clk N (default 0: no limit)\n");
+    printf("  -l, --list-queue    use the linked list ready queue instead of the heap\n");
+    printf("  -c, --cores N       simulated cores, each with its own ready queue, idle cores steal (default 1)\n");
+    printf("  -d, --devices N     I/O devices, each with its own wait queue (default 1)\n");
+    printf("  -b, --io-bursts N   up to N I/O bursts per process (default 1)\n");
+    printf("  -r, --ready-q Q     ready queue for SJF/priority: list, heap, simd (default heap)\n");
+    printf("      --arrivals A    arrival times: uniform (1~20), poisson (default uniform)\n");
+    printf("      --arrival-mean X    mean time between Poisson arrivals (default 12.5)\n");
+    printf("      --bursts B      CPU bursts: uniform (1~20), lognormal, pareto, bimodal (default uniform)\n");
+    printf("      --burst-mean X      mean CPU burst of lognormal/pareto/bimodal batch bursts (default 10)\n");
+    printf("      --burst-shape X     lognormal sigma (default 1) or Pareto alpha > 1 (default 1.5)\n");
+    printf("      --interactive F     bimodal: fraction of short interactive bursts (default 0.7)\n");
+    printf("      --prio-weights L    relative weights of priorities 1~%d, e.g. 1,2,4,1 (default uniform)\n", MAX_PRIORITY);
+    printf("      --trace FILE    replay a binary trace instead of generating processes (-n is ignored)\n");
+    printf("      --export-trace FILE      write the generated processes as a binary trace, and exit\n");
+    printf("      --import-csv CSV FILE    convert pid,arrival,priority,cpu_burst[,io_gap,io_len,io_device]... lines\n");
+    printf("      --checkpoint FILE   stop at -t and write a snapshot of the whole simulation state to FILE\n");
+    printf("      --restore FILE      continue the simulation of a snapshot (workload options are ignored,\n");
+    printf("                          -a/-q/-r/--levels/... switch the policy from there on)\n");
+    printf("      --fork-algos L      at -t, fork the simulation once per algorithm of L and run each fork to the end\n");
+    printf("      --bench-select  time _SJF() selection: list scan vs SIMD key array vs heap, and exit\n");
+    printf("      --bench         time the simulator: every algorithm over --nums (10~1M), --loads (percent, default\n");
+    printf("                      50,90,150) and --quanta (RR/MLFQ/CFS/lottery/stride, default 2,10), with -e/-r/-c, and exit\n");
+    printf("      --bench-loops   time the loop specialized for each algorithm against the generic one over --algos,\n");
+    printf("                      --nums (default 100000) and --loads (default 90), with -q/-e/-r/-c, and exit\n");
+    printf("      --generic-loop  simulate with the generic loop instead of the one specialized for the algorithm\n");
+    printf("  -v, --verbose       print the log while simulating (log level 2)\n");
+    printf("      --log-level N   0: off, 1: state changes, 2: + idle clks (default 0)\n");
+    printf("      --log-file F    write the event log to F (binary)\n");
+    printf("      --log-size N    event log ring buffer size in records (default 65536)\n");
+    printf("      --print-log F   print a binary event log as text and exit\n");
+    printf("      --timeline F    write the CPU and I/O timeline (segments, queue lengths, preemptions) to F as\n");
+    printf("                      Chrome trace-event JSON, streamed while simulating (Perfetto, chrome://tracing)\n");
+    printf("      --timeline-bin F    the same as compact binary records\n");
+    printf("      --print-timeline F  convert a binary timeline to trace-event JSON and exit\n");
+    printf("      --no-header     omit the csv header line\n");
+    printf("  parameter sweep (any of these runs every combination, lists: 1,2,5 or 1:10 or 0:100:10):\n");
+    printf("      --algos L       algorithms\n");
+    printf("      --quanta L      time quanta (RR, MLFQ, CFS, lottery, stride only)\n");
+    printf("      --nums L        numbers of processes\n");
+    printf("      --seeds L       random seeds\n");
+    printf("  -j, --threads N     worker threads for the sweep (default 1) or the comparison (default: one per algorithm)\n");
+    printf("  comparison:\n");
+    printf("      --compare L     run the algorithms of L concurrently on one workload, created once (or read from\n");
+    printf("                      --trace), and print one table of the metrics with the winner of each\n");
+}
+
+
+static int _parse_list(const char* spec, int* out, int max);
+
+int run_batch(int argc, char** argv){
+    /*
+    Headless mode: configuration comes from argv, the simulation runs to completion
+    without terminal input and a summary (text/json/csv) is printed at the end.
+    */
+    Config cfg = {
+        .rand_pid = true,
+        .rand_arrival = true,
+        .use_priority = false,
+        .rand_cpu_burst = true,
+        .rand_io_burst = true,
+        .num_process = 5,
+        .algo = 5,
+        .quantum = 5,
+        .mlfq_levels = 3,
+        .mlfq_quanta = {0},
+        .mlfq_boost = 100,
+        .cfs_latency = 12,
+        .deadline_factor = 0,
+        .num_tasks = 0,
+        .task_util = 0.8,
+        .task_deadline = 1,
+        .admit = false,
+        .tickets = {0},
+        .max_time = 0,
+        .ready_q_type = 1,
+        .engine = 0,
+        .num_cores = 1,
+        .num_devices = 1,
+        .io_bursts = 1,
+        .trace_file = NULL,
+        .arrival_dist = 0,
+        .arrival_mean = 12.5,
+        .burst_dist = 0,
+        .burst_mean = 10,
+        .burst_shape = 1,
+        .interactive_frac = 0.7,
+        .prio_weights = {0},
+        .keep_gannt = false,
+        .profile = false,
+        .generic_loop = false,
+        .interactive = false,
+        .log_level = 0,
+        .verbose = false,
+        .log_size = 65536,
+        .log_file = NULL,
+        .timeline_file = NULL,
+        .timeline_binary = false,
+        .seed = 98,
+        .format = 0
+    };
+    bool header = true;
+    bool sweep = false;
+    bool bench_sel = false;
+    bool bench_loop = false;
+    bool bench = false;
+    const char *loads = NULL;
+    bool shape_set = false;
+    bool levels_set = false;
+    const char *export_path = NULL;
+    const char *checkpoint_path = NULL, *restore_path = NULL, *forks = NULL;
+    bool policy_set = false;    // the command line picks the policy (a restored run switches to it)
+    const char *algos = NULL, *quanta = NULL, *nums = NULL, *seeds = NULL;
+    const char *compare = NULL;
+    int num_workers = 1;
+    bool workers_set = false;
+
+    for(int i=1; i<argc; i++){
+        char* opt = argv[i];
+        char* val = (i+1 < argc) ? argv[i+1] : NULL;
+        bool need_val = true;
+        if(!strcmp(opt, "-a") || !strcmp(opt, "--algo")){
+            if(val){cfg.algo = atoi(val);}
+            policy_set = true;
+        }
+        else if(!strcmp(opt, "-q") || !strcmp(opt, "--quantum")){
+            if(val){cfg.quantum = atoi(val);}
+            policy_set = true;
+        }
+        else if(!strcmp(opt, "-n") || !strcmp(opt, "--num")){
+            if(val){cfg.num_process = atoi(val);}
+        }
+        else if(!strcmp(opt, "-s") || !strcmp(opt, "--seed")){
+            if(val){cfg.seed = atoi(val);}
+        }
+        else if(!strcmp(opt, "-t") || !strcmp(opt, "--max-time")){
+            if(val){cfg.max_time = atoll(val);}
+        }
+        else if(!strcmp(opt, "-f") || !strcmp(opt, "--format")){
+            if(val){cfg.format = !strcmp(val, "json") ? 1 : !strcmp(val, "csv") ? 2 : 0;}
+        }
+        else if(!strcmp(opt, "-e") || !strcmp(opt, "--engine")){
+            if(val){cfg.engine = !strcmp(val, "event") ? 1 : 0;}
+        }
+        else if(!strcmp(opt, "--log-level")){
+            if(val){cfg.log_level = atoi(val);}
+        }
+        else if(!strcmp(opt, "--log-file")){
+            cfg.log_file = val;
+        }
+        else if(!strcmp(opt, "--log-size")){
+            if(val){cfg.log_size = atoi(val);}
+        }
+        else if(!strcmp(opt, "--timeline") || !strcmp(opt, "--timeline-bin")){
+            cfg.timeline_file = val;
+            cfg.timeline_binary = !strcmp(opt, "--timeline-bin");
+        }
+        else if(!strcmp(opt, "--algos")){
+            algos = val;
+            sweep = true;
+        }
+        else if(!strcmp(opt, "--quanta")){
+            quanta = val;
+            sweep = true;
+        }
+        else if(!strcmp(opt, "--nums")){
+            nums = val;
+            sweep = true;
+        }
+        else if(!strcmp(opt, "--loads")){
+            loads = val;
+        }
+        else if(!strcmp(opt, "--seeds")){
+            seeds = val;
+            sweep = true;
+        }
+        else if(!strcmp(opt, "-j") || !strcmp(opt, "--threads")){
+            if(val){num_workers = atoi(val);}
+            workers_set = true;
+        }
+        else if(!strcmp(opt, "--compare")){
+            compare = val;
+        }
+        else if(!strcmp(opt, "-c") || !strcmp(opt, "--cores")){
+            if(val){cfg.num_cores = atoi(val);}
+        }
+        else if(!strcmp(opt, "-d") || !strcmp(opt, "--devices")){
+            if(val){cfg.num_devices = atoi(val);}
+        }
+        else if(!strcmp(opt, "-b") || !strcmp(opt, "--io-bursts")){
+            if(val){cfg.io_bursts = atoi(val);}
+        }
+        else if(!strcmp(opt, "-r") || !strcmp(opt, "--ready-q")){
+            if(val){cfg.ready_q_type = !strcmp(val, "list") ? 0 : !strcmp(val, "simd") ? 2 : 1;}
+            policy_set = true;
+        }
+        else if(!strcmp(opt, "--arrivals")){
+            if(val){cfg.arrival_dist = !strcmp(val, "poisson") ? 1 : !strcmp(val, "uniform") ? 0 : -1;}
+        }
+        else if(!strcmp(opt, "--arrival-mean")){
+            if(val){cfg.arrival_mean = atof(val);}
+        }
+        else if(!strcmp(opt, "--bursts")){
+            if(val){cfg.burst_dist = !strcmp(val, "uniform") ? 0 : !strcmp(val, "lognormal") ? 1 :
+                                     !strcmp(val, "pareto") ? 2 : !strcmp(val, "bimodal") ? 3 : -1;}
+            if(val && cfg.burst_dist == 2 && !shape_set){
+                cfg.burst_shape = 1.5;
+            }
+        }
+        else if(!strcmp(opt, "--burst-mean")){
+            if(val){cfg.burst_mean = atof(val);}
+        }
+        else if(!strcmp(opt, "--burst-shape")){
+            if(val){cfg.burst_shape = atof(val);}
+            shape_set = true;
+        }
+        else if(!strcmp(opt, "--interactive")){
+            if(val){cfg.interactive_frac = atof(val);}
+        }
+        else if(!strcmp(opt, "--levels")){
+            if(val){cfg.mlfq_levels = atoi(val);}
+            levels_set = true;
+            policy_set = true;
+        }
+        else if(!strcmp(opt, "--level-quanta")){
+            int n = val ? _parse_list(val, cfg.mlfq_quanta, MLFQ_MAX_LEVELS) : 0;
+            if(val && n < 1){
+                printf("Error: --level-quanta needs 1 ~ %d quanta\n", MLFQ_MAX_LEVELS);
+                return 1;
+            }
+            if(val && !levels_set){
+                cfg.mlfq_levels = n;
+            }
+            policy_set = true;
+        }
+        else if(!strcmp(opt, "--boost")){
+            if(val){cfg.mlfq_boost = atoi(val);}
+            policy_set = true;
+        }
+        else if(!strcmp(opt, "--latency")){
+            if(val){cfg.cfs_latency = atoi(val);}
+            policy_set = true;
+        }
+        else if(!strcmp(opt, "--deadline")){
+            if(val){cfg.deadline_factor = atof(val);}
+        }
+        else if(!strcmp(opt, "--tasks")){
+            if(val){cfg.num_tasks = atoi(val);}
+        }
+        else if(!strcmp(opt, "--utilization")){
+            if(val){cfg.task_util = atof(val);}
+        }
+        else if(!strcmp(opt, "--task-deadline")){
+            if(val){cfg.task_deadline = atof(val);}
+        }
+        else if(!strcmp(opt, "--tickets")){
+            int t[MAX_PRIORITY];
+            if(val && _parse_list(val, t, MAX_PRIORITY) != MAX_PRIORITY){
+                printf("Error: --tickets needs %d ticket counts\n", MAX_PRIORITY);
+                return 1;
+            }
+            for(int j=0; val && j<MAX_PRIORITY; j++){
+                if(t[j] < 1){
+                    printf("Error: ticket counts must be positive\n");
+                    return 1;
+                }
+                cfg.tickets[j] = t[j];
+            }
+            policy_set = true;
+        }
+        else if(!strcmp(opt, "--prio-weights")){
+            int w[MAX_PRIORITY];
+            if(val && _parse_list(val, w, MAX_PRIORITY) != MAX_PRIORITY){
+                printf("Error: --prio-weights needs %d weights\n", MAX_PRIORITY);
+                return 1;
+            }
+            for(int j=0; val && j<MAX_PRIORITY; j++){
+                cfg.prio_weights[j] = w[j];
+            }
+        }
+        else if(!strcmp(opt, "--trace")){
+            cfg.trace_file = val;
+        }
+        else if(!strcmp(opt, "--export-trace")){
+            export_path = val;
+        }
+        else if(!strcmp(opt, "--checkpoint")){
+            checkpoint_path = val;
+        }
+        else if(!strcmp(opt, "--restore")){
+            restore_path = val;
+        }
+        else if(!strcmp(opt, "--fork-algos")){
+            forks = val;
+        }
+        else if(!strcmp(opt, "--import-csv")){
+            if(val == NULL || i+2 >= argc){
+                printf("Error: --import-csv needs a csv file and a trace file\n");
+                return 1;
+            }
+            return import_csv_trace(val, argv[i+2]);
+        }
+        else if(!strcmp(opt, "--print-log")){
+            return val ? print_log_file(val) : 1;
+        }
+        else if(!strcmp(opt, "--print-timeline")){
+            return val ? print_timeline_file(val) : 1;
+        }
+        else{
+            need_val = false;
+            if(!strcmp(opt, "-l") || !strcmp(opt, "--list-queue")){
+                cfg.ready_q_type = 0;
+            }
+            else if(!strcmp(opt, "-v") || !strcmp(opt, "--verbose")){
+                cfg.verbose = true;
+                cfg.log_level = 2;
+            }
+            else if(!strcmp(opt, "--no-header")){
+                header = false;
+            }
+            else if(!strcmp(opt, "--bench-select")){
+                bench_sel = true;
+            }
+            else if(!strcmp(opt, "--bench")){
+                bench = true;
+            }
+            else if(!strcmp(opt, "--bench-loops")){
+                bench_loop = true;
+            }
+            else if(!strcmp(opt, "--generic-loop")){
+                cfg.generic_loop = true;
+            }
+            else if(!strcmp(opt, "--admit")){
+                cfg.admit = true;
+            }
+            else{
+                _batch_usage();
+                return !strcmp(opt, "-h") || !strcmp(opt, "--help") ? 0 : 1;
+            }
+        }
+        if(need_val){
+            if(val == NULL){
+                printf("Error: %s needs a value\n", opt);
+                return 1;
+            }
+            i++;
+        }
+    }
+    if(cfg.algo < 0 || cfg.algo > MAX_ALGO || cfg.num_process < 1 || cfg.quantum < 1 || cfg.num_cores < 1 ||
+       cfg.num_devices < 1 || cfg.io_bursts < 1 || cfg.arrival_dist < 0 || cfg.arrival_mean <= 0 ||
+       cfg.burst_dist < 0 || cfg.burst_mean < 1 || cfg.burst_shape <= 0 || (cfg.burst_dist == 2 && cfg.burst_shape <= 1) ||
+       (cfg.burst_dist != 2 && cfg.burst_shape > 4) ||
+       cfg.interactive_frac < 0 || cfg.interactive_frac > 1 ||
+       cfg.mlfq_levels < 1 || cfg.mlfq_levels > MLFQ_MAX_LEVELS || cfg.mlfq_boost < 0 ||
+       cfg.cfs_latency < 0 || cfg.deadline_factor < 0 || cfg.num_tasks < 0 || cfg.num_tasks > MAX_TASKS ||
+       cfg.task_util <= 0 || cfg.task_deadline <= 0){
+        printf("Error: invalid configuration\n");
+        _batch_usage();
+        return 1;
+    }
+    for(int i=0; i<MLFQ_MAX_LEVELS; i++){
+        if(cfg.mlfq_quanta[i] < 0){
+            printf("Error: MLFQ quanta must be positive\n");
+            return 1;
+        }
+    }
+    cfg.use_priority = _uses_priority(cfg.algo);
+    if(cfg.num_cores > 1){
+        cfg.engine = 0; // the event engine models one CPU
+    }
+    if(cfg.num_tasks > 0 && cfg.trace_file != NULL){
+        printf("Error: --tasks generates the processes, it can't be used with --trace\n");
+        return 1;
+    }
+    if(cfg.admit){
+        if(cfg.num_tasks == 0){
+            printf("Error: --admit tests a periodic task set (--tasks)\n");
+            return 1;
+        }
+        // the task set create_process() will draw: make_task_set() is the first use of the seeded generator
+        Task tasks[MAX_TASKS];
+        Rng rng;
+        rng_seed(&rng, (uint64_t)cfg.seed);
+        int n = make_task_set(&cfg, &rng, tasks);
+        double util, density;
+        long long fail_at;
+        if(!admission_test(tasks, n, &util, &density, &fail_at)){
+            if(fail_at < 0){
+                printf("Error: task set rejected, utilization %.4f > 1\n", util);
+            }
+            else{
+                printf("Error: task set rejected, more than %lld clk of work is due by clk %lld (utilization %.4f, density %.4f)\n",
+                       fail_at, fail_at, util, density);
+            }
+            return 3;
+        }
+        if(cfg.format == 0){
+            printf("Task set admitted: %d tasks, utilization %.4f, density %.4f\n", n, util, density);
+        }
+    }
+
+    if(cfg.log_file != NULL && cfg.log_level == 0){
+        cfg.log_level = 2;
+    }
+
+    if(export_path != NULL){
+        return export_trace(&cfg, export_path);
+    }
+    if(bench_sel){
+        return bench_select(cfg.format);
+    }
+    if(bench){
+        return run_bench(&cfg, algos, quanta, nums, loads);
+    }
+    if(bench_loop){
+        return bench_loops(&cfg, algos, nums, loads);
+    }
+    if(compare != NULL){
+        if(sweep || checkpoint_path != NULL || restore_path != NULL || forks != NULL){
+            printf("Error: --compare can't be combined with a sweep or checkpoints\n");
+            return 1;
+        }
+        return run_compare(&cfg, compare, workers_set ? num_workers : 0, header);
+    }
+    if(checkpoint_path != NULL || restore_path != NULL || forks != NULL){
+        if(cfg.num_cores > 1 || cfg.trace_file != NULL){
+            printf("Error: checkpoints are for single CPU runs of generated processes (no -c, --trace)\n");
+            return 1;
+        }
+        if(checkpoint_path != NULL && cfg.max_time == 0){
+            printf("Error: --checkpoint needs the clk to stop at (-t)\n");
+            return 1;
+        }
+        return run_checkpoint(&cfg, restore_path, checkpoint_path, forks, policy_set, header);
+    }
+    if(sweep){
+        return run_sweep(&cfg, algos, quanta, nums, seeds, num_workers, header);
+    }
+
+    Eval ev;
+    double wall_sec;
+    simulate(&cfg, &ev, &wall_sec);
+    print_summary(&cfg, &ev, wall_sec, header);
+    return (ev.num_process == cfg.num_process) ? 0 : 2;
+}
+
+
+static void _free_queue(Queue* q){
+    free(q->heap);
+    free(q->fen);
+    free(q->lv);
+    free(q->lq);
+    free(q->key);
+    free(q->kseq);
+    free(q);
+}
+
+
+void free_table(Table* tbl){
+    /*
+    Free a Table and everything that hangs off it (processes in new_pool, queues, gannt chart, log, timeline export)
+    */
+    if(tbl->tl_out != NULL){
+        // the segments still open end here
+        for(int i=0; i<((tbl->cores != NULL) ? tbl->num_cores : 1); i++){
+            Timeline *tl = (tbl->cores != NULL) ? &tbl->cores[i]->gannt : &tbl->gannt;
+            Segment *last = (tl->cnt > 0) ? &tl->seg[tl->tail_only ? 0 : tl->cnt-1] : NULL;
+            if(last != NULL && last->pid != -1){
+                timeline_rec(tbl->tl_out, TL_CPU, tl->track, last->start, last->end - last->start, last->pid, 0);
+            }
+        }
+        close_timeline(tbl->tl_out);
+    }
+    free(tbl->proc_block);
+    free(tbl->io_block);
+    free(tbl->new_pool);
+    _free_queue(tbl->ready_q);
+    _free_queue(tbl->term_q);
+    for(int i=0; i<tbl->io->num_devices; i++){
+        _free_queue(tbl->io->dev[i].wait_q);
+    }
+    free(tbl->io->dev);
+    free(tbl->io->done->heap);
+    free(tbl->io->done);
+    free(tbl->io->start);
+    free(tbl->io);
+    if(tbl->trace != NULL){
+        close_trace(tbl->trace);
+    }
+    free(tbl->gannt.seg);
+    free(tbl->stats);
+    for(int i=0; tbl->cores != NULL && i<tbl->num_cores; i++){
+        // I/O devices, term_q, stats and the log belong to tbl
+        _free_queue(tbl->cores[i]->ready_q);
+        free(tbl->cores[i]->gannt.seg);
+        free(tbl->cores[i]);
+    }
+    free(tbl->cores);
+    if(tbl->log != NULL){
+        close_event_log(tbl->log);
+    }
+    free(tbl);
+}
+
+
+// checkpoint, restore and fork (single CPU, generated processes)
+
+static void _snap_put(Snap* s, const void* data, size_t n){
+    /* append n bytes, padded to 8 so every section starts aligned */
+    size_t pad = (n + 7) & ~(size_t)7;
+    if(s->len + pad > s->cap){
+        s->cap = (s->cap == 0) ? 4096 : s->cap;
+        while(s->len + pad > s->cap){
+            s->cap *= 2;
+        }
+        s->buf = (char*)realloc(s->buf, s->cap);
+    }
+    if(n > 0){
+        memcpy(s->buf + s->len, data, n);
+    }
+    memset(s->buf + s->len + n, 0, pad - n);
+    s->len += pad;
+}
+
+
+static const void* _snap_get(Snap* s, size_t n){
+    /* next n bytes of a snapshot, in place (8-byte aligned) */
+    size_t pad = (n + 7) & ~(size_t)7;
+    if(s->off + pad > s->len){
+        printf("Error: snapshot is truncated\n");
+        exit(1);
+    }
+    const void *p = s->buf + s->off;
+    s->off += pad;
+    return p;
+}
+
+
+static int _snap_get_int(Snap* s){
+    int v;
+    memcpy(&v, _snap_get(s, sizeof(int)), sizeof(int));
+    return v;
+}
+
+
+static void _snap_list(Snap* s, Queue* l, Process* base){
+    /* a linked list as its length and the indices (in proc_block) of its processes, head first */
+    int *idx = (int*)malloc(sizeof(int)*(l->cnt + 1));
+    int cnt = 0;
+    for(Node *n = l->head; n != NULL; n = n->right){
+        idx[cnt++] = (int)(n->p - base);
+    }
+    _snap_put(s, &cnt, sizeof(int));
+    _snap_put(s, idx, sizeof(int)*cnt);
+    free(idx);
+}
+
+
+static void _snap_queue(Snap* s, Queue* q, Process* base){
+    /*
+    A Queue as written by snapshot_table(): the struct itself (its pointers are not used when restoring),
+    then the processes in their exact positions (list order, heap/array slots), so the restored queue
+    selects exactly what this one would
+    */
+    _snap_put(s, q, sizeof(Queue));
+    if(q->type == 0){
+        _snap_list(s, q, base);
+        return;
+    }
+    if(q->type == 5){
+        _snap_put(s, q->lq, sizeof(int)*q->levels);
+        for(int i=0; i<q->levels; i++){
+            _snap_list(s, &q->lv[i], base);
+        }
+        return;
+    }
+    int *idx = (int*)malloc(sizeof(int)*(q->cnt + 1));
+    for(int i=0; i<q->cnt; i++){
+        idx[i] = (int)(q->heap[i] - base);
+    }
+    _snap_put(s, idx, sizeof(int)*q->cnt);
+    free(idx);
+    if(q->type == 3 || q->type == 4){
+        _snap_put(s, q->key, sizeof(int)*q->cnt);
+        _snap_put(s, q->kseq, sizeof(long long)*q->cnt);
+    }
+}
+
+
+static void _restore_list(Snap* s, Queue* l, Queue* owner, Process* base){
+    /* link the processes of a list written by _snap_list() (Node.q: owner, the MLFQ itself for its levels) */
+    int cnt = _snap_get_int(s);
+    const int *idx = (const int*)_snap_get(s, sizeof(int)*cnt);
+    l->head = NULL;
+    l->tail = NULL;
+    l->cnt = 0;
+    for(int i=0; i<cnt; i++){
+        Node *n = &base[idx[i]].node;
+        n->q = owner;
+        n->left = l->tail;
+        n->right = NULL;
+        if(l->tail == NULL){
+            l->head = n;
+        }
+        else{
+            l->tail->right = n;
+        }
+        l->tail = n;
+        l->cnt++;
+    }
+}
+
+
+static Queue* _restore_queue(Snap* s, Process* base, long long* clk){
+    /* a Queue written by _snap_queue(), timed with `clk` if the original was timed */
+    Queue *q = (Queue*)malloc(sizeof(Queue));
+    memcpy(q, _snap_get(s, sizeof(Queue)), sizeof(Queue));
+    q->clk = (q->clk != NULL) ? clk : NULL;
+    q->heap = NULL;
+    q->key = NULL;
+    q->kseq = NULL;
+    q->lv = NULL;
+    q->lq = NULL;
+    q->fen = NULL;
+    if(q->type == 0){
+        _restore_list(s, q, q, base);
+        return q;
+    }
+    q->head = NULL;
+    q->tail = NULL;
+    if(q->type == 5){
+        q->lq = (int*)malloc(sizeof(int)*q->levels);
+        memcpy(q->lq, _snap_get(s, sizeof(int)*q->levels), sizeof(int)*q->levels);
+        q->lv = (Queue*)calloc(q->levels, sizeof(Queue));
+        for(int i=0; i<q->levels; i++){
+            _restore_list(s, &q->lv[i], q, base);
+        }
+        return q;
+    }
+    q->heap = (Process**)malloc(sizeof(Process*)*q->cap);
+    const int *idx = (const int*)_snap_get(s, sizeof(int)*q->cnt);
+    for(int i=0; i<q->cnt; i++){
+        q->heap[i] = &base[idx[i]];
+    }
+    if(q->type == 3 || q->type == 4){
+        q->key = (int*)malloc(sizeof(int)*q->cap);
+        q->kseq = (long long*)malloc(sizeof(long long)*q->cap);
+        memcpy(q->key, _snap_get(s, sizeof(int)*q->cnt), sizeof(int)*q->cnt);
+        memcpy(q->kseq, _snap_get(s, sizeof(long long)*q->cnt), sizeof(long long)*q->cnt);
+    }
+    if(q->type == 8){
+        _fen_build(q);
+    }
+    return q;
+}
+
+
+void snapshot_table(Table* tbl, Config* cfg, Snap* s){
+    /*
+    Serialize everything a simulation continues from: clk, quantum, RNG, counters, the queues (ready, term,
+    I/O wait queues, running_p and the processes on the devices), every Process and its I/O bursts,
+    new_pool, the metrics so far (Stats) and the gannt chart. Pointers are written as indices
+    (processes) or rebuilt (queues); the event log is not part of it (it is output, not state)
+    */
+    if(tbl->cores != NULL || tbl->trace != NULL){
+        printf("Error: only single CPU simulations of generated processes can be checkpointed\n");
+        exit(1);
+    }
+    Process *base = tbl->proc_block;
+    int max_io = (cfg->io_bursts > 1) ? cfg->io_bursts : 1;
+    size_t start = s->len;
+    SnapHeader hdr = {SNAP_MAGIC, SNAP_VERSION, {(int)sizeof(Process), (int)sizeof(Queue), (int)sizeof(Config),
+                      (int)sizeof(Stats)}, 0, tbl->clk, cfg->algo, tbl->pool_cnt, (uint64_t)(uintptr_t)tbl->io_block};
+    _snap_put(s, &hdr, sizeof(SnapHeader));
+
+    Config c = *cfg;
+    c.trace_file = NULL;
+    c.log_file = NULL;
+    c.timeline_file = NULL;
+    _snap_put(s, &c, sizeof(Config));
+    _snap_put(s, tbl, sizeof(Table));
+    int running = (tbl->running_p != NULL) ? (int)(tbl->running_p - base) : -1;
+    _snap_put(s, &running, sizeof(int));
+    _snap_put(s, tbl->stats, sizeof(Stats));
+    int segs = (tbl->gannt.seg == NULL) ? 0 : tbl->gannt.tail_only ? 1 : tbl->gannt.cnt;
+    _snap_put(s, &segs, sizeof(int));
+    _snap_put(s, tbl->gannt.seg, sizeof(Segment)*segs);
+
+    _snap_put(s, base, sizeof(Process)*tbl->pool_cnt);
+    _snap_put(s, tbl->io_block, sizeof(IoBurst)*tbl->pool_cnt*max_io);
+    int *pool = (int*)malloc(sizeof(int)*(tbl->pool_cnt + 1));
+    for(int i=0; i<tbl->pool_cnt; i++){
+        pool[i] = (int)(tbl->new_pool[i] - base);
+    }
+    _snap_put(s, pool, sizeof(int)*tbl->pool_cnt);
+    free(pool);
+
+    _snap_queue(s, tbl->ready_q, base);
+    _snap_queue(s, tbl->term_q, base);
+    DeviceSet *io = tbl->io;
+    _snap_put(s, io, sizeof(DeviceSet));
+    for(int i=0; i<io->num_devices; i++){
+        Device *d = &io->dev[i];
+        int io_p = (d->io_p != NULL) ? (int)(d->io_p - base) : -1;
+        _snap_put(s, d, sizeof(Device));
+        _snap_put(s, &io_p, sizeof(int));
+        _snap_queue(s, d->wait_q, base);
+    }
+    _snap_put(s, io->done, sizeof(EventQueue));
+    _snap_put(s, io->done->heap, sizeof(Event)*io->done->cnt);
+    _snap_put(s, io->start, sizeof(int)*io->start_cnt);
+
+    ((SnapHeader*)(s->buf + start))->size = (long long)(s->len - start);
+}
+
+
+static bool _policy_changed(Config* a, Config* b){
+    /* true if the ready queue of `a` can't go on as the ready queue of `b` */
+    return a->algo != b->algo || a->quantum != b->quantum || _ready_q_type(a) != _ready_q_type(b) ||
+           a->mlfq_levels != b->mlfq_levels || a->mlfq_boost != b->mlfq_boost || a->cfs_latency != b->cfs_latency ||
+           memcmp(a->mlfq_quanta, b->mlfq_quanta, sizeof(a->mlfq_quanta)) != 0 ||
+           memcmp(a->tickets, b->tickets, sizeof(a->tickets)) != 0;
+}
+
+
+static int _cmp_q_seq(const void* a, const void* b){
+    long long x = (*(Process* const*)a)->q_seq, y = (*(Process* const*)b)->q_seq;
+    return (x > y) - (x < y);
+}
+
+
+static void _switch_policy(Table* tbl, Config* cfg){
+    /*
+    Continue a simulation with the algorithm (and policy parameters) of cfg: the ready processes move to a new
+    ready queue in the order they entered the old one (lists: head first, MLFQ: top level first, heaps and arrays: Process.q_seq),
+    their ready wait so far is accounted, and the state of the old policy (level, allotment, vruntime, pass,
+    tickets) is dropped from every live process, so they start the new policy as if they had just arrived.
+    running_p keeps the CPU and gets a fresh quantum
+    */
+    Queue *old = tbl->ready_q;
+    Process **ready = (Process**)malloc(sizeof(Process*)*(old->cnt + 1));
+    int n = 0;
+    if(old->type == 0){
+        for(Node *nd = old->head; nd != NULL; nd = nd->right){
+            ready[n++] = nd->p;
+        }
+    }
+    else if(old->type == 5){
+        mlfq_top(old);  // apply a boost that is due
+        for(int i=0; i<old->levels; i++){
+            for(Node *nd = old->lv[i].head; nd != NULL; nd = nd->right){
+                ready[n++] = nd->p;
+            }
+        }
+    }
+    else{
+        memcpy(ready, old->heap, sizeof(Process*)*old->cnt);
+        n = old->cnt;
+        qsort(ready, n, sizeof(Process*), _cmp_q_seq);
+    }
+    for(int i=0; i<n; i++){
+        dequeue(old, ready[i]);
+        share_leave(tbl->stats, ready[i]);
+    }
+    if(tbl->running_p != NULL){
+        share_leave(tbl->stats, tbl->running_p);
+    }
+    for(int i=0; i<tbl->pool_cnt; i++){
+        Process *p = &tbl->proc_block[i];
+        if(p->state != 4){
+            p->level = 0;
+            p->slice = -1;
+            p->epoch = -1;
+            p->vruntime = -1;
+            p->pass = -1;
+            p->tickets = 0;
+        }
+    }
+    _free_queue(old);
+
+    Queue *q = create_ready_queue(cfg, &tbl->clk);
+    tbl->ready_q = q;
+    tbl->quantum = cfg->quantum;
+    Process *p = tbl->running_p;
+    if(p != NULL){
+        if(q->type == 6){
+            cfs_place(q, p);
+        }
+        if(q->type == 8 || q->type == 9){
+            p->tickets = _tickets_of(q, p);
+        }
+        if(q->type == 9){
+            stride_place(q, p);
+        }
+        share_join(tbl->stats, p);
+    }
+    for(int i=0; i<n; i++){
+        enqueue(q, ready[i]);
+        share_join(tbl->stats, ready[i]);
+    }
+    free(ready);
+}
+
+
+Table* restore_table(Snap* s, Config* cfg, bool new_policy){
+    /*
+    Rebuild a Table from a snapshot written by snapshot_table() (reads s from s->off).
+    cfg: in: how to run from here (max_time, engine, log, format) and, if new_policy, the algorithm and its parameters
+         to continue with (the ready queue is converted, see _switch_policy()),
+         out: the configuration of the restored simulation (the workload is the snapshot's)
+    */
+    size_t start = s->off;
+    SnapHeader hdr;
+    memcpy(&hdr, _snap_get(s, sizeof(SnapHeader)), sizeof(SnapHeader));
+    if(hdr.magic != SNAP_MAGIC || hdr.version != SNAP_VERSION){
+        printf("Error: not a snapshot (or a different version)\n");
+        exit(1);
+    }
+    if(hdr.sizes[0] != (int)sizeof(Process) || hdr.sizes[1] != (int)sizeof(Queue) ||
+       hdr.sizes[2] != (int)sizeof(Config) || hdr.sizes[3] != (int)sizeof(Stats)){
+        printf("Error: the snapshot was written by a different build\n");
+        exit(1);
+    }
+    if(hdr.size > (long long)(s->len - start)){
+        printf("Error: snapshot is truncated\n");
+        exit(1);
+    }
+
+    Config run = *cfg;
+    memcpy(cfg, _snap_get(s, sizeof(Config)), sizeof(Config));
+    Config saved = *cfg;
+    cfg->max_time = run.max_time;
+    cfg->engine = run.engine;
+    cfg->generic_loop = run.generic_loop;
+    cfg->profile = run.profile;
+    cfg->interactive = run.interactive;
+    cfg->log_level = run.log_level;
+    cfg->verbose = run.verbose;
+    cfg->log_size = run.log_size;
+    cfg->log_file = run.log_file;
+    cfg->timeline_file = run.timeline_file;
+    cfg->timeline_binary = run.timeline_binary;
+    cfg->format = run.format;
+    if(new_policy){
+        cfg->algo = run.algo;
+        cfg->quantum = run.quantum;
+        cfg->mlfq_levels = run.mlfq_levels;
+        memcpy(cfg->mlfq_quanta, run.mlfq_quanta, sizeof(cfg->mlfq_quanta));
+        cfg->mlfq_boost = run.mlfq_boost;
+        cfg->cfs_latency = run.cfs_latency;
+        memcpy(cfg->tickets, run.tickets, sizeof(cfg->tickets));
+        cfg->ready_q_type = run.ready_q_type;
+    }
+
+    Table *tbl = (Table*)malloc(sizeof(Table));
+    memcpy(tbl, _snap_get(s, sizeof(Table)), sizeof(Table));
+    int running = _snap_get_int(s);
+    tbl->stats = (Stats*)malloc(sizeof(Stats));
+    memcpy(tbl->stats, _snap_get(s, sizeof(Stats)), sizeof(Stats));
+    int segs = _snap_get_int(s);
+    tbl->gannt.seg = NULL;
+    if(tbl->gannt.cap > 0){
+        tbl->gannt.seg = (Segment*)malloc(sizeof(Segment)*tbl->gannt.cap);
+        memcpy(tbl->gannt.seg, _snap_get(s, sizeof(Segment)*segs), sizeof(Segment)*segs);
+    }
+
+    int count = tbl->pool_cnt;
+    int max_io = (cfg->io_bursts > 1) ? cfg->io_bursts : 1;
+    Process *base = (Process*)malloc(sizeof(Process)*count);
+    memcpy(base, _snap_get(s, sizeof(Process)*count), sizeof(Process)*count);
+    tbl->io_block = (IoBurst*)malloc(sizeof(IoBurst)*count*max_io);
+    memcpy(tbl->io_block, _snap_get(s, sizeof(IoBurst)*count*max_io), sizeof(IoBurst)*count*max_io);
+    for(int i=0; i<count; i++){
+        Process *p = &base[i];
+        if(p->io_seq != NULL){
+            p->io_seq = tbl->io_block + ((uintptr_t)p->io_seq - (uintptr_t)hdr.io_base) / sizeof(IoBurst);
+        }
+        p->node.p = p;
+        p->node.left = NULL;
+        p->node.right = NULL;
+        p->node.q = NULL;
+    }
+    tbl->proc_block = base;
+    tbl->new_pool = (Process**)malloc(sizeof(Process*)*count);
+    const int *pool = (const int*)_snap_get(s, sizeof(int)*count);
+    for(int i=0; i<count; i++){
+        tbl->new_pool[i] = &base[pool[i]];
+    }
+    tbl->running_p = (running >= 0) ? &base[running] : NULL;
+
+    tbl->ready_q = _restore_queue(s, base, &tbl->clk);
+    tbl->ready_q->prof = cfg->profile;
+    tbl->term_q = _restore_queue(s, base, &tbl->clk);
+    DeviceSet *io = (DeviceSet*)malloc(sizeof(DeviceSet));
+    memcpy(io, _snap_get(s, sizeof(DeviceSet)), sizeof(DeviceSet));
+    io->dev = (Device*)malloc(sizeof(Device)*io->num_devices);
+    for(int i=0; i<io->num_devices; i++){
+        Device *d = &io->dev[i];
+        memcpy(d, _snap_get(s, sizeof(Device)), sizeof(Device));
+        int io_p = _snap_get_int(s);
+        d->io_p = (io_p >= 0) ? &base[io_p] : NULL;
+        d->wait_q = _restore_queue(s, base, &tbl->clk);
+    }
+    EventQueue done;
+    memcpy(&done, _snap_get(s, sizeof(EventQueue)), sizeof(EventQueue));
+    io->done = create_event_queue(done.cap);
+    io->done->cnt = done.cnt;
+    io->done->allocs = done.allocs;
+    memcpy(io->done->heap, _snap_get(s, sizeof(Event)*done.cnt), sizeof(Event)*done.cnt);
+    io->start = (int*)malloc(sizeof(int)*io->num_devices);
+    memcpy(io->start, _snap_get(s, sizeof(int)*io->start_cnt), sizeof(int)*io->start_cnt);
+    tbl->io = io;
+
+    tbl->trace = NULL;
+    tbl->cores = NULL;
+    tbl->log = (cfg->log_level > 0) ? create_event_log(cfg->log_size, cfg->log_level, cfg->verbose, cfg->log_file) : NULL;
+    tbl->tl_out = (cfg->timeline_file != NULL) ? open_timeline(cfg->timeline_file, cfg->timeline_binary, 1, io->num_devices) : NULL;
+    tbl->gannt.out = tbl->tl_out;
+    if(_policy_changed(&saved, cfg)){
+        _switch_policy(tbl, cfg);
+    }
+    return tbl;
 }
 
 
-int io_service(Table* tbl, int algo){
-    /* Service I/O burst for 1 clock cycle
-    1. Schedule: If io_p is NULL, select a Process from wait_q to perform I/O,
-        - if wait_q is also empty, return NULL.
+Table* fork_table(Table* tbl, Config* cfg, Config* fork_cfg){
+    /*
+    An independent copy of a live simulation (its snapshot, restored in memory) that continues with fork_cfg:
+    its algorithm and policy parameters, and how to run (see restore_table()). The fork keeps no log file
+    and exports no timeline
+    */
+    Snap s = {NULL, 0, 0, 0};
+    snapshot_table(tbl, cfg, &s);
+    fork_cfg->log_file = NULL;
+    fork_cfg->timeline_file = NULL;
+    Table *fork = restore_table(&s, fork_cfg, true);
+    free(s.buf);
+    return fork;
+}
 
-    2. I/O service: decrement io_burst_rem by 1
-        - if io_burst_rem == 0, move io_p to ready queue
-        - if io_burst_rem > 0, return NULL
 
-    Returns
-    -------
-    -1 if no process available to perform I/O
-    0 if I/O burst is completed (tbl->io_p == NULL)
-    else: remaining I/O burst time
-     */
-    // 1. Schedule
-    if(tbl->io_p == NULL){
-        if(tbl->wait_q->head == NULL){
-            return -1;    // no process available to perform I/O
+int save_snapshot(Table* tbl, Config* cfg, const char* path){
+    /* write the snapshot of a simulation to `path` (--checkpoint) */
+    FILE *out = fopen(path, "wb");
+    if(out == NULL){
+        printf("Error: couldn't open %s\n", path);
+        return 1;
+    }
+    Snap s = {NULL, 0, 0, 0};
+    snapshot_table(tbl, cfg, &s);
+    size_t written = fwrite(s.buf, 1, s.len, out);
+    fclose(out);
+    free(s.buf);
+    if(written != s.len){
+        printf("Error: couldn't write %s\n", path);
+        return 1;
+    }
+    return 0;
+}
+
+
+Table* load_snapshot(const char* path, Config* cfg, bool new_policy){
+    /* map a snapshot file and restore the simulation from it (--restore), see restore_table() */
+    int fd = open(path, O_RDONLY);
+    if(fd < 0){
+        printf("Error: couldn't open snapshot %s\n", path);
+        exit(1);
+    }
+    struct stat st;
+    if(fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(SnapHeader)){
+        printf("Error: %s is not a snapshot\n", path);
+        exit(1);
+    }
+    char *map = (char*)mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(map == MAP_FAILED){
+        printf("Error: couldn't map snapshot %s\n", path);
+        exit(1);
+    }
+    madvise(map, st.st_size, MADV_SEQUENTIAL);
+    Snap s = {map, (size_t)st.st_size, 0, 0};
+    Table *tbl = restore_table(&s, cfg, new_policy);
+    munmap(map, st.st_size);
+    return tbl;
+}
+
+
+static double _run(Table* tbl, Config* cfg){
+    /* run a simulation from where it is with the loop for cfg (until the end or cfg->max_time), returns the wall time */
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    if(tbl->cores != NULL){
+        run_multi(tbl, cfg);
+    }
+    else if(cfg->engine == 1){
+        run_event(tbl, cfg);
+    }
+    else{
+        run_tick(tbl, cfg);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    return (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec)*1e-9;
+}
+
+
+void simulate(Config* cfg, Eval* ev, double* wall_sec){
+    /*
+    Run one non-interactive simulation from start to end and return its metrics.
+    Uses nothing but its own Table, so it can be called from several threads at once
+    */
+    Table *tbl = create_table(cfg);
+    if(tbl->trace == NULL){
+        create_process(tbl, cfg);
+    }
+
+    *wall_sec = _run(tbl, cfg);
+
+    compute_eval(tbl, ev);
+    free_table(tbl);    // also writes the rest of the log to Config.log_file
+}
+
+
+int run_checkpoint(Config* cfg, const char* restore_path, const char* save_path, const char* forks,
+                   bool new_policy, bool header){
+    /*
+    Checkpointed run: start from a snapshot (--restore, the policy switches if new_policy) or from scratch,
+    run until cfg->max_time, then write a snapshot (--checkpoint) and/or continue a fork of the simulation
+    with each algorithm of `forks` (--fork-algos) to the end. Prints a summary of the run, or one per fork
+    */
+    Table *tbl;
+    if(restore_path != NULL){
+        tbl = load_snapshot(restore_path, cfg, new_policy);
+    }
+    else{
+        tbl = create_table(cfg);
+        create_process(tbl, cfg);
+    }
+    double wall_sec = 0;
+    if(forks == NULL || cfg->max_time > 0){
+        /* without -t the forks branch off right where the simulation starts (or was restored) */
+        wall_sec = _run(tbl, cfg);
+    }
+    if(save_path != NULL){
+        if(save_snapshot(tbl, cfg, save_path) != 0){
+            free_table(tbl);
+            return 1;
+        }
+        if(cfg->format == 0){
+            printf("Checkpoint at clk %lld written to %s\n", tbl->clk, save_path);
+        }
+    }
+
+    Eval ev;
+    int ret = 0;
+    if(forks == NULL){
+        compute_eval(tbl, &ev);
+        print_summary(cfg, &ev, wall_sec, header);
+        ret = (ev.num_process == cfg->num_process) ? 0 : 2;
+    }
+    else{
+        int algo_v[MAX_ALGO+1];
+        int na = _parse_list(forks, algo_v, MAX_ALGO+1);
+        if(na < 1){
+            printf("Error: invalid --fork-algos list\n");
+            free_table(tbl);
+            return 1;
+        }
+        for(int a=0; a<na; a++){
+            if(algo_v[a] < 0 || algo_v[a] > MAX_ALGO){
+                printf("Error: invalid --fork-algos list\n");
+                free_table(tbl);
+                return 1;
+            }
+            Config fork_cfg = *cfg;
+            fork_cfg.algo = algo_v[a];
+            fork_cfg.max_time = 0;
+            Table *fork = fork_table(tbl, cfg, &fork_cfg);
+            double fork_sec = _run(fork, &fork_cfg);
+            compute_eval(fork, &ev);
+            print_summary(&fork_cfg, &ev, fork_sec, header && a == 0);
+            ret = (ev.num_process == fork_cfg.num_process) ? ret : 2;
+            free_table(fork);
+        }
+    }
+    free_table(tbl);
+    return ret;
+}
+
+
+static int _parse_list(const char* spec, int* out, int max){
+    /*
+    Parse a list of ints such as "1,2,5" or "1:10" or "0:100:10" (start:end:step, end inclusive)
+    Returns the number of values (-1 on error)
+    */
+    int cnt = 0;
+    const char* c = spec;
+    while(*c != '\0'){
+        int a, b, step = 1, used;
+        if(sscanf(c, "%d%n", &a, &used) != 1){
+            return -1;
+        }
+        c += used;
+        b = a;
+        if(*c == ':'){
+            if(sscanf(c+1, "%d%n", &b, &used) != 1){
+                return -1;
+            }
+            c += used + 1;
+            if(*c == ':'){
+                if(sscanf(c+1, "%d%n", &step, &used) != 1 || step < 1){
+                    return -1;
+                }
+                c += used + 1;
+            }
+        }
+        for(int v=a; v<=b; v+=step){
+            if(cnt == max){
+                return -1;
+            }
+            out[cnt++] = v;
+        }
+        if(*c == ','){
+            c++;
+        }
+        else if(*c != '\0'){
+            return -1;
+        }
+    }
+    return cnt;
+}
+
+
+static bool _take_task(Sweep* sw, int self, int* task, bool* stolen){
+    /*
+    Pop the next task of worker `self` from the bottom of its deque,
+    or steal from the top of another worker's deque if its own is empty
+    */
+    WorkDeque *dq = &sw->deques[self];
+    pthread_mutex_lock(&dq->lock);
+    if(dq->top < dq->bottom){
+        *task = dq->task[--dq->bottom];
+        pthread_mutex_unlock(&dq->lock);
+        *stolen = false;
+        return true;
+    }
+    pthread_mutex_unlock(&dq->lock);
+
+    for(int k=1; k<sw->num_workers; k++){
+        WorkDeque *victim = &sw->deques[(self + k) % sw->num_workers];
+        pthread_mutex_lock(&victim->lock);
+        if(victim->top < victim->bottom){
+            *task = victim->task[victim->top++];
+            pthread_mutex_unlock(&victim->lock);
+            *stolen = true;
+            return true;
+        }
+        pthread_mutex_unlock(&victim->lock);
+    }
+    return false;   // no task left anywhere (tasks never spawn new ones)
+}
+
+
+typedef struct _WorkerArg{
+    Sweep* sw;
+    int self;
+}_WorkerArg;
+
+
+static void* _sweep_worker(void* arg){
+    Sweep *sw = ((_WorkerArg*)arg)->sw;
+    int self = ((_WorkerArg*)arg)->self;
+    int task;
+    bool stolen;
+    while(_take_task(sw, self, &task, &stolen)){
+        SweepTask *t = &sw->tasks[task];
+        if(t->wl != NULL){
+            simulate_workload(t->wl, &t->cfg, &t->ev, &t->wall_sec);
         }
         else{
-            tbl->io_p = tbl->wait_q->head->p;
-            printf("<@%d> I/O START: [%d] (%d I/O clock)\n", tbl->clk, tbl->io_p->pid, tbl->io_p->io_burst_rem);
-            dequeue(tbl->wait_q, tbl->io_p);
-            tbl->io_p->state = 3;   // waiting
+            simulate(&t->cfg, &t->ev, &t->wall_sec);
+        }
+        if(stolen){
+            sw->steals[self]++;
         }
     }
-    // 2. I/O service
-    tbl->io_p->io_burst_rem--;
-    return tbl->io_p->io_burst_rem;
+    return NULL;
 }
 
 
-Process* _SJF(Queue* q){
-    /* 
-    Returns the process with the shortest CPU burst time in the queue.
+static double _run_pool(Sweep* sw, int num_workers, long long* steals){
+    /*
+    Run every task of sw on `num_workers` threads (at least 1), returns the wall time.
+    Tasks are dealt out in contiguous blocks, stealing evens out the rest
     */
+    if(num_workers < 1){
+        num_workers = 1;
+    }
+    sw->num_workers = num_workers;
+    sw->deques = (WorkDeque*)malloc(sizeof(WorkDeque)*num_workers);
+    sw->steals = (long long*)calloc(num_workers, sizeof(long long));
+    for(int w=0; w<num_workers; w++){
+        int lo = (int)((long long)sw->num_tasks*w/num_workers);
+        int hi = (int)((long long)sw->num_tasks*(w+1)/num_workers);
+        sw->deques[w].task = (int*)malloc(sizeof(int)*((hi > lo) ? hi-lo : 1));
+        sw->deques[w].top = 0;
+        sw->deques[w].bottom = hi - lo;
+        for(int i=lo; i<hi; i++){
+            sw->deques[w].task[hi-1-i] = i;  // owner pops from the bottom, so keep grid order
+        }
+        pthread_mutex_init(&sw->deques[w].lock, NULL);
+    }
 
-    // check if ready queue is empty
-    if(q->head == NULL){
-        return NULL;
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    pthread_t *threads = (pthread_t*)malloc(sizeof(pthread_t)*num_workers);
+    _WorkerArg *args = (_WorkerArg*)malloc(sizeof(_WorkerArg)*num_workers);
+    for(int w=0; w<num_workers; w++){
+        args[w].sw = sw;
+        args[w].self = w;
+        pthread_create(&threads[w], NULL, _sweep_worker, &args[w]);
+    }
+    for(int w=0; w<num_workers; w++){
+        pthread_join(threads[w], NULL);
     }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
 
-    Node* curr = q->head;   // not NULL
-    Node* min_node = q->head;  // not NULL
+    *steals = 0;
+    for(int w=0; w<num_workers; w++){
+        *steals += sw->steals[w];
+        pthread_mutex_destroy(&sw->deques[w].lock);
+        free(sw->deques[w].task);
+    }
+    free(sw->deques);
+    free(sw->steals);
+    free(threads);
+    free(args);
+    return (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec)*1e-9;
+}
 
-    // seek ready queue
-    while(curr != NULL){
-        if(curr->p->cpu_burst_rem < min_node->p->cpu_burst_rem){    // schedule earlier process if same cpu_burst_rem
-            min_node = curr;
+
+int run_sweep(Config* base, const char* algos, const char* quanta, const char* nums, const char* seeds,
+              int num_workers, bool header){
+    /*
+    The quantum only matters for RR, MLFQ, CFS, lottery and stride, so other algorithms are run once per (n, seed).
+    on a pool of `num_workers` threads and print all summaries as one table (in grid order).
+    The quantum only matters for RR, MLFQ and CFS, so other algorithms are run once per (n, seed).
+    */
+    int algo_v[16], quantum_v[1024], num_v[1024], seed_v[65536];
+    int na = algos ? _parse_list(algos, algo_v, 16) : 1;
+    int nq = quanta ? _parse_list(quanta, quantum_v, 1024) : 1;
+    int nn = nums ? _parse_list(nums, num_v, 1024) : 1;
+    int ns = seeds ? _parse_list(seeds, seed_v, 65536) : 1;
+    if(!algos){algo_v[0] = base->algo;}
+    if(!quanta){quantum_v[0] = base->quantum;}
+    if(!nums){num_v[0] = base->num_process;}
+    if(!seeds){seed_v[0] = base->seed;}
+    if(na < 1 || nq < 1 || nn < 1 || ns < 1){
+        printf("Error: invalid sweep list\n");
+        return 1;
+    }
+
+    Sweep sw;
+    sw.tasks = (SweepTask*)malloc(sizeof(SweepTask)*na*nq*nn*ns);
+    sw.num_tasks = 0;
+    for(int a=0; a<na; a++){
+        for(int q=0; q<nq; q++){
+            if(!_uses_quantum(algo_v[a]) && q > 0){
+                break;
+            }
+            for(int n=0; n<nn; n++){
+                for(int sd=0; sd<ns; sd++){
+                    Config cfg = *base;
+                    cfg.algo = algo_v[a];
+                    cfg.quantum = quantum_v[q];
+                    cfg.num_process = num_v[n];
+                    cfg.seed = seed_v[sd];
+                    cfg.use_priority = _uses_priority(cfg.algo);
+                    cfg.log_level = 0;
+                    cfg.verbose = false;
+                    cfg.log_file = NULL;
+                    cfg.timeline_file = NULL;
+                    if(cfg.algo < 0 || cfg.algo > MAX_ALGO || cfg.quantum < 1 || cfg.num_process < 1){
+                        printf("Error: invalid sweep configuration\n");
+                        free(sw.tasks);
+                        return 1;
+                    }
+                    sw.tasks[sw.num_tasks].wl = NULL;
+                    sw.tasks[sw.num_tasks++].cfg = cfg;
+                }
+            }
         }
-        curr = curr->right;
-    } // curr == NULL
+    }
 
-    return min_node->p;
+    long long steals;
+    double wall_sec = _run_pool(&sw, num_workers, &steals);
+
+    // merged table
+    long long ticks = 0;
+    for(int i=0; i<sw.num_tasks; i++){
+        print_summary(&sw.tasks[i].cfg, &sw.tasks[i].ev, sw.tasks[i].wall_sec, header && i == 0);
+        ticks += sw.tasks[i].ev.finish_clk;
+    }
+    fprintf(stderr, "sweep: %d simulations on %d threads in %.3f sec (%.1f sims/sec, %.1f clk/sec, %lld stolen)\n",
+            sw.num_tasks, sw.num_workers, wall_sec, sw.num_tasks/wall_sec, ticks/wall_sec, steals);
+    free(sw.tasks);
+    return 0;
 }
 
 
-Process* _PRIO(Queue* q, Process* running_p){
+int bench_select(int format){
     /*
-    Priority Scheduling: Returns Process* with the highest priority
+    Micro benchmark of SJF selection on a large ready queue (--bench-select):
+    linked list scan (nodes shuffled in memory, as they are after a long run), key array scan (SIMD)
+    and heap. Each round selects the shortest job, dequeues it and enqueues it again with a new burst,
+    which is what the scheduler does on every dispatch. Every queue starts from the same bursts,
+    so all of them must select the same jobs (check)
+    */
+    const int sizes[] = {10000, 100000, 1000000};
+    const int types[] = {0, 3, 1};
+    const char* names[] = {"list", "simd", "heap"};
+    Rng rng;
+    rng_seed(&rng, 98);
 
-    
-    Process* running_p: currently running process
+    if(format == 2){
+        printf("queue,ready,rounds,ns_per_select\n");
+    }
+    else{
+        printf("%-6s %10s %8s %14s\n", "queue", "ready", "rounds", "ns/select");
+    }
+    for(int s=0; s<3; s++){
+        int n = sizes[s];
+        int rounds = 20000000 / n;
+        Process *block = (Process*) calloc(n, sizeof(Process));
+        Process **order = (Process**) malloc(sizeof(Process*)*n);
+        int *burst = (int*) malloc(sizeof(int)*n);
+        for(int i=0; i<n; i++){
+            block[i].pid = i;
+            burst[i] = 1 + rng_below(&rng, MAX_CPU_BURST*1000);
+            block[i].heap_idx = -1;
+            block[i].node.p = &block[i];
+            order[i] = &block[i];
+        }
+        // enqueue in random order so list neighbours are far apart in memory
+        for(int i=n-1; i>0; i--){
+            int j = rng_below(&rng, i+1);
+            Process *tmp = order[i];
+            order[i] = order[j];
+            order[j] = tmp;
+        }
+        long long first_check = 0;
+        for(int t=0; t<3; t++){
+            Queue *q = create_queue(types[t]);
+            for(int i=0; i<n; i++){
+                order[i]->cpu_burst_rem = burst[order[i]->pid];
+                enqueue(q, order[i]);
+            }
+            long long check = 0;
+            struct timespec t0, t1;
+            clock_gettime(CLOCK_MONOTONIC, &t0);
+            for(int r=0; r<rounds; r++){
+                Process *p = _SJF(q);
+                check += p->pid;
+                dequeue(q, p);
+                p->cpu_burst_rem = 1 + (int)((p->pid * 2654435761u + r) % (MAX_CPU_BURST*1000));
+                enqueue(q, p);
+            }
+            clock_gettime(CLOCK_MONOTONIC, &t1);
+            double ns = ((t1.tv_sec - t0.tv_sec)*1e9 + (t1.tv_nsec - t0.tv_nsec)) / rounds;
+            if(format == 2){
+                printf("%s,%d,%d,%.1f\n", names[t], n, rounds, ns);
+            }
+            else{
+                printf("%-6s %10d %8d %14.1f   (check %lld)\n", names[t], n, rounds, ns, check);
+            }
+            while(q->cnt > 0){
+                dequeue(q, (q->type == 0) ? q->head->p : q->heap[0]);
+            }
+            free(q->heap);
+            free(q->key);
+            free(q->kseq);
+            free(q);
+            if(t == 0){
+                first_check = check;
+            }
+            else if(check != first_check){
+                printf("Error: %s selected other jobs than %s (check %lld, %lld)\n", names[t], names[0], check, first_check);
+                free(burst);
+                free(order);
+                free(block);
+                return 1;
+            }
+        }
+        free(burst);
+        free(order);
+        free(block);
+    }
+    return 0;
+}
+
+
+static long long _peak_rss_kb(bool reset){
+    /*
+    Peak resident set size of this process in KB (VmHWM, getrusage() where there is no /proc).
+    reset: start a new peak (Linux clear_refs), otherwise later runs would report the peak of earlier ones.
+    Memory freed by the previous run is handed back first, or it would count towards the next peak
     */
+    if(reset){
+#ifdef __GLIBC__
+        malloc_trim(0);
+#endif
+        FILE *f = fopen("/proc/self/clear_refs", "w");
+        if(f != NULL){
+            fputs("5", f);
+            fclose(f);
+        }
+        return 0;
+    }
+    long long kb = -1;
+    char line[256];
+    FILE *f = fopen("/proc/self/status", "r");
+    while(f != NULL && fgets(line, sizeof(line), f) != NULL){
+        if(!strncmp(line, "VmHWM:", 6)){
+            kb = atoll(line + 6);
+            break;
+        }
+    }
+    if(f != NULL){
+        fclose(f);
+    }
+    if(kb < 0){
+        struct rusage ru;
+        getrusage(RUSAGE_SELF, &ru);
+        kb = ru.ru_maxrss;
+    }
+    return kb;
+}
 
-    // check if ready queue is empty
-    if(q->head == NULL){
-        return running_p;   // empty ready queue. Keep running_p. IDLE if running_p == NULL
+
+int run_bench(Config* base, const char* algos, const char* quanta, const char* nums, const char* loads){
+    /*
+    Benchmark of the simulator itself (--bench): every algorithm x number of processes x load x quantum (RR/MLFQ/CFS/lottery/stride only),
+    one run at a time with the engine, ready queue and cores of `base`.
+    Load is the CPU time offered per clk in percent: Poisson arrivals with a mean gap of (mean CPU burst / load)
+    (I/O comes on top, so non-preemptive algorithms that stall on I/O saturate below 100).
+    Reports simulated clks/sec, scheduling decisions (dispatches)/sec, ns per _SJF()/_PRIO() call
+    (one in SEL_SAMPLE timed, cost of the timer subtracted) and peak RSS, as text, csv or one JSON document
+    */
+    const char* ready_q_names[] = {"list", "heap", "simd"};
+    int algo_v[16], quantum_v[64], num_v[64], load_v[64];
+    char all_algos[16];
+    snprintf(all_algos, sizeof(all_algos), "0:%d", MAX_ALGO);
+    int na = _parse_list(algos ? algos : all_algos, algo_v, 16);
+    int nq = _parse_list(quanta ? quanta : "2,10", quantum_v, 64);
+    int nn = _parse_list(nums ? nums : "10,1000,100000,1000000", num_v, 64);
+    int nl = _parse_list(loads ? loads : "50,90,150", load_v, 64);
+    if(na < 1 || nq < 1 || nn < 1 || nl < 1){
+        printf("Error: invalid benchmark list\n");
+        return 1;
+    }
+    double mean_burst = (base->burst_dist != 0) ? base->burst_mean :
+                        base->rand_cpu_burst ? (MAX_CPU_BURST + 1) / 2.0 : DEFAULT_CPU_BURST;
+
+    // what one timed selection costs with nothing to select
+    const int calib = 100000;
+    long long timer_sum = 0;
+    for(int i=0; i<calib; i++){
+        long long t = _now_ns();
+        timer_sum += _now_ns() - t;
+    }
+    double timer_ns = (double)timer_sum / calib;
+
+    switch(base->format){
+        case 1:
+            printf("{\"benchmark\":\"cpu_scheduler\",\"engine\":\"%s\",\"ready_q\":\"%s\",\"cores\":%d,\"devices\":%d,"
+                   "\"io_bursts\":%d,\"seed\":%d,\"timer_ns\":%.1f,\"runs\":[\n",
+                   (base->engine == 1) ? "event" : "tick", ready_q_names[base->ready_q_type], base->num_cores,
+                   base->num_devices, base->io_bursts, base->seed, timer_ns);
+            break;
+        case 2:
+            printf("algo,quantum,num_process,load,finish_clk,wall_sec,ticks_per_sec,dispatches,decisions_per_sec,"
+                   "select_calls,ns_per_select,peak_rss_kb\n");
+            break;
+        default:
+            printf("engine: %s, ready queue: %s, cores: %d, timer: %.1f ns\n", (base->engine == 1) ? "event" : "tick",
+                   ready_q_names[base->ready_q_type], base->num_cores, timer_ns);
+            printf("%-6s %4s %8s %5s %11s %9s %13s %13s %10s %9s\n", "algo", "q", "procs", "load", "clk", "wall_s",
+                   "ticks/s", "decisions/s", "ns/select", "rss_KB");
+    }
+
+    int runs = 0;
+    for(int a=0; a<na; a++){
+        for(int q=0; q<nq; q++){
+            if(!_uses_quantum(algo_v[a]) && q > 0){
+                break;
+            }
+            for(int n=0; n<nn; n++){
+                for(int l=0; l<nl; l++){
+                    Config cfg = *base;
+                    cfg.algo = algo_v[a];
+                    cfg.quantum = quantum_v[q];
+                    cfg.num_process = num_v[n];
+                    cfg.use_priority = _uses_priority(cfg.algo);
+                    cfg.arrival_dist = 1;
+                    cfg.arrival_mean = mean_burst * 100.0 / load_v[l];
+                    cfg.profile = true;
+                    cfg.log_level = 0;
+                    cfg.verbose = false;
+                    cfg.log_file = NULL;
+                    cfg.timeline_file = NULL;
+                    if(cfg.algo < 0 || cfg.algo > MAX_ALGO || cfg.quantum < 1 || cfg.num_process < 1 || load_v[l] < 1){
+                        printf("Error: invalid benchmark configuration\n");
+                        return 1;
+                    }
+
+                    Eval ev;
+                    double wall_sec;
+                    _peak_rss_kb(true);
+                    simulate(&cfg, &ev, &wall_sec);
+                    long long rss = _peak_rss_kb(false);
+                    double tps = (wall_sec > 0) ? ev.finish_clk / wall_sec : 0.0;
+                    double dps = (wall_sec > 0) ? ev.dispatches / wall_sec : 0.0;
+                    double ns = (ev.select_ns > timer_ns) ? ev.select_ns - timer_ns : 0.0;
+                    const char* name = _algo_name(cfg.algo, false);
+
+                    switch(base->format){
+                        case 1:
+                            printf("%s{\"algo\":\"%s\",\"quantum\":%d,\"num_process\":%d,\"load\":%.2f,\"finish_clk\":%lld,"
+                                   "\"wall_sec\":%.6f,\"ticks_per_sec\":%.1f,\"dispatches\":%lld,\"decisions_per_sec\":%.1f,"
+                                   "\"select_calls\":%lld,", (runs > 0) ? ",\n" : "", name, cfg.quantum, cfg.num_process,
+                                   load_v[l]/100.0, ev.finish_clk, wall_sec, tps, ev.dispatches, dps, ev.select_calls);
+                            if(ev.select_calls > 0){
+                                printf("\"ns_per_select\":%.1f,", ns);
+                            }
+                            else{
+                                printf("\"ns_per_select\":null,");
+                            }
+                            printf("\"peak_rss_kb\":%lld}", rss);
+                            break;
+                        case 2:
+                            printf("%s,%d,%d,%.2f,%lld,%.6f,%.1f,%lld,%.1f,%lld,%.1f,%lld\n", name, cfg.quantum, cfg.num_process,
+                                   load_v[l]/100.0, ev.finish_clk, wall_sec, tps, ev.dispatches, dps, ev.select_calls, ns, rss);
+                            break;
+                        default:
+                            printf("%-6s %4d %8d %5.2f %11lld %9.3f %13.0f %13.0f ", name, cfg.quantum, cfg.num_process,
+                                   load_v[l]/100.0, ev.finish_clk, wall_sec, tps, dps);
+                            if(ev.select_calls > 0){
+                                printf("%10.1f %9lld\n", ns, rss);
+                            }
+                            else{
+                                printf("%10s %9lld\n", "-", rss);
+                            }
+                    }
+                    fflush(stdout);
+                    runs++;
+                }
+            }
+        }
+    }
+    if(base->format == 1){
+        printf("\n]}\n");
+    }
+    return 0;
+}
+
+
+static int _cmp_double(const void* a, const void* b){
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+
+int bench_loops(Config* base, const char* algos, const char* nums, const char* loads){
+    /*
+    Benchmark of the specialized simulation loops (--bench-loops): every algorithm x number of processes x load
+    is simulated with the loop specialized for the algorithm and with the generic loop (Config.generic_loop),
+    alternately, BENCH_REPEAT times. Reports the median simulated clks/sec of each, and the median and
+    quartiles of the speedups of the pairs (a pair runs back to back, so drift of the machine cancels out).
+    Both loops produce the same schedule, so finish_clk must match
+    */
+    enum{BENCH_REPEAT = 15};
+    int algo_v[16], num_v[64], load_v[64];
+    char all_algos[16];
+    snprintf(all_algos, sizeof(all_algos), "0:%d", MAX_ALGO);
+    int na = _parse_list(algos ? algos : all_algos, algo_v, 16);
+    int nn = _parse_list(nums ? nums : "100000", num_v, 64);
+    int nl = _parse_list(loads ? loads : "90", load_v, 64);
+    if(na < 1 || nn < 1 || nl < 1){
+        printf("Error: invalid benchmark list\n");
+        return 1;
+    }
+    double mean_burst = (base->burst_dist != 0) ? base->burst_mean :
+                        base->rand_cpu_burst ? (MAX_CPU_BURST + 1) / 2.0 : DEFAULT_CPU_BURST;
+
+    switch(base->format){
+        case 1:
+            printf("{\"benchmark\":\"loops\",\"engine\":\"%s\",\"cores\":%d,\"repeat\":%d,\"runs\":[\n",
+                   (base->engine == 1) ? "event" : "tick", base->num_cores, BENCH_REPEAT);
+            break;
+        case 2:
+            printf("algo,num_process,load,finish_clk,specialized_ticks_per_sec,generic_ticks_per_sec,speedup,"
+                   "speedup_q1,speedup_q3\n");
+            break;
+        default:
+            printf("engine: %s, cores: %d, medians of %d runs\n", (base->engine == 1) ? "event" : "tick", base->num_cores,
+                   BENCH_REPEAT);
+            printf("%-8s %8s %5s %11s %15s %15s %8s %15s\n", "algo", "procs", "load", "clk", "specialized/s", "generic/s",
+                   "speedup", "q1~q3");
+    }
+
+    int runs = 0;
+    for(int a=0; a<na; a++){
+        for(int n=0; n<nn; n++){
+            for(int l=0; l<nl; l++){
+                Config cfg = *base;
+                cfg.algo = algo_v[a];
+                cfg.num_process = num_v[n];
+                cfg.use_priority = _uses_priority(cfg.algo);
+                cfg.arrival_dist = 1;
+                cfg.arrival_mean = mean_burst * 100.0 / load_v[l];
+                cfg.profile = false;
+                cfg.log_level = 0;
+                cfg.verbose = false;
+                cfg.log_file = NULL;
+                cfg.timeline_file = NULL;
+                if(cfg.algo < 0 || cfg.algo > MAX_ALGO || cfg.num_process < 1 || load_v[l] < 1){
+                    printf("Error: invalid benchmark configuration\n");
+                    return 1;
+                }
+
+                double tps[2][BENCH_REPEAT];  // clks/sec of every run, specialized and generic
+                double ratio[BENCH_REPEAT];   // speedup of every pair
+                long long finish[2] = {0, 0};
+                for(int r=0; r<BENCH_REPEAT; r++){
+                    for(int g=0; g<2; g++){
+                        Eval ev;
+                        double wall_sec;
+                        cfg.generic_loop = ((g + r) % 2 == 1);  // alternate which loop runs first
+                        simulate(&cfg, &ev, &wall_sec);
+                        int k = cfg.generic_loop ? 1 : 0;
+                        tps[k][r] = (wall_sec > 0) ? ev.finish_clk / wall_sec : 0.0;
+                        finish[k] = ev.finish_clk;
+                    }
+                    ratio[r] = (tps[1][r] > 0) ? tps[0][r] / tps[1][r] : 0.0;
+                }
+                if(finish[0] != finish[1]){
+                    printf("Error: %s specialized loop finished at clk %lld, generic loop at clk %lld\n",
+                           _algo_name(cfg.algo, false), finish[0], finish[1]);
+                    return 1;
+                }
+                qsort(tps[0], BENCH_REPEAT, sizeof(double), _cmp_double);
+                qsort(tps[1], BENCH_REPEAT, sizeof(double), _cmp_double);
+                qsort(ratio, BENCH_REPEAT, sizeof(double), _cmp_double);
+                double med[2] = {tps[0][BENCH_REPEAT/2], tps[1][BENCH_REPEAT/2]};
+                double speedup = ratio[BENCH_REPEAT/2];
+                double q1 = ratio[BENCH_REPEAT/4], q3 = ratio[BENCH_REPEAT*3/4];
+                const char* name = _algo_name(cfg.algo, false);
+
+                switch(base->format){
+                    case 1:
+                        printf("%s{\"algo\":\"%s\",\"num_process\":%d,\"load\":%.2f,\"finish_clk\":%lld,"
+                               "\"specialized_ticks_per_sec\":%.1f,\"generic_ticks_per_sec\":%.1f,\"speedup\":%.3f,"
+                               "\"speedup_q1\":%.3f,\"speedup_q3\":%.3f}",
+                               (runs > 0) ? ",\n" : "", name, cfg.num_process, load_v[l]/100.0, finish[0],
+                               med[0], med[1], speedup, q1, q3);
+                        break;
+                    case 2:
+                        printf("%s,%d,%.2f,%lld,%.1f,%.1f,%.3f,%.3f,%.3f\n", name, cfg.num_process, load_v[l]/100.0,
+                               finish[0], med[0], med[1], speedup, q1, q3);
+                        break;
+                    default:
+                        printf("%-8s %8d %5.2f %11lld %15.0f %15.0f %7.2fx %7.2fx~%.2fx\n", name, cfg.num_process,
+                               load_v[l]/100.0, finish[0], med[0], med[1], speedup, q1, q3);
+                }
+                fflush(stdout);
+                runs++;
+            }
+        }
+    }
+    if(base->format == 1){
+        printf("\n]}\n");
+    }
+    return 0;
+}
+
+
+Trace* open_trace(const char* path, Config* cfg){
+    /*
+    Map a binary trace (see TraceHeader) for replay. Sets cfg->num_process to the number of records
+    and raises cfg->num_devices to the devices the trace uses. Records are only read as they arrive
+    */
+    int fd = open(path, O_RDONLY);
+    if(fd < 0){
+        printf("Error: couldn't open trace %s\n", path);
+        exit(1);
+    }
+    struct stat st;
+    if(fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(TraceHeader)){
+        printf("Error: %s is not a trace\n", path);
+        exit(1);
+    }
+    const char *map = (const char*)mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(map == MAP_FAILED){
+        printf("Error: couldn't map trace %s\n", path);
+        exit(1);
+    }
+    madvise((void*)map, st.st_size, MADV_SEQUENTIAL);
+
+    Trace *tr = (Trace*)calloc(1, sizeof(Trace));
+    tr->map = map;
+    tr->size = st.st_size;
+    memcpy(&tr->hdr, map, sizeof(TraceHeader));
+    tr->off = sizeof(TraceHeader);
+    if(tr->hdr.magic != TRACE_MAGIC || tr->hdr.version != TRACE_VERSION){
+        printf("Error: %s is not a trace (or a different version)\n", path);
+        exit(1);
+    }
+    if(tr->hdr.count < 1 || tr->hdr.count > INT_MAX){
+        printf("Error: %s has %lld records (1 ~ %d supported)\n", path, tr->hdr.count, INT_MAX);
+        exit(1);
+    }
+    cfg->num_process = (int)tr->hdr.count;
+    if(tr->hdr.devices > cfg->num_devices){
+        cfg->num_devices = tr->hdr.devices;
+    }
+    tr->last_arrival = LLONG_MIN;
+    tr->deadline_factor = cfg->deadline_factor;
+    return tr;
+}
+
+
+static void _trace_free_slot(Trace* tr, Process* p){
+    if(tr->free_cnt == tr->free_cap){
+        tr->free_cap = (tr->free_cap == 0) ? TRACE_CHUNK : tr->free_cap*2;
+        tr->free_p = (Process**)realloc(tr->free_p, sizeof(Process*)*tr->free_cap);
+    }
+    tr->free_p[tr->free_cnt++] = p;
+}
+
+
+static Process* _trace_read(Trace* tr){
+    /*
+    Turn the next record into a Process (in a reused slot if a process has terminated).
+    Its io_seq points into the mapping, the bursts are not copied
+    */
+    if(tr->free_cnt == 0){
+        if(tr->chunk_cnt == tr->chunk_cap){
+            tr->chunk_cap = (tr->chunk_cap == 0) ? 16 : tr->chunk_cap*2;
+            tr->chunk = (Process**)realloc(tr->chunk, sizeof(Process*)*tr->chunk_cap);
+        }
+        Process *chunk = (Process*)malloc(sizeof(Process)*TRACE_CHUNK);
+        tr->chunk[tr->chunk_cnt++] = chunk;
+        for(int i=TRACE_CHUNK-1; i>=0; i--){
+            _trace_free_slot(tr, &chunk[i]);
+        }
     }
-    
-    // max_priority = -1 if no running_p
-    int running_priority = (running_p == NULL) ? -1 : running_p->priority;
-    int max_priority = running_priority;
-    Node* curr = q->head;
-    Node* max_node = q->head;
 
-    // seek ready queue
-    while(curr != NULL){
-        if(curr->p->priority > max_priority){
-            max_node = curr;
-            max_priority = curr->p->priority;
+    TraceRec rec;
+    if(tr->off + sizeof(TraceRec) > tr->size){
+        printf("Error: trace ends after %lld of %lld records\n", tr->read, tr->hdr.count);
+        exit(1);
+    }
+    memcpy(&rec, tr->map + tr->off, sizeof(TraceRec));
+    tr->off += sizeof(TraceRec);
+    if(rec.io_cnt < 0 || rec.io_cnt > tr->hdr.max_io || tr->off + sizeof(IoBurst)*rec.io_cnt > tr->size ||
+       rec.cpu_burst < 1 || rec.priority < 0 || rec.priority > MAX_PRIORITY || rec.arrival < tr->last_arrival){
+        printf("Error: trace record %lld is invalid (or not in arrival order)\n", tr->read);
+        exit(1);
+    }
+    Process *p = tr->free_p[--tr->free_cnt];
+    p->pid = rec.pid;
+    p->arrival_time = rec.arrival;
+    p->priority = rec.priority;
+    p->cpu_burst_init = rec.cpu_burst;
+    p->cpu_burst_rem = rec.cpu_burst;
+    p->io_seq = (IoBurst*)(tr->map + tr->off);  // read only
+    p->io_cnt = rec.io_cnt;
+    for(int i=0; i<rec.io_cnt; i++){
+        if(p->io_seq[i].gap < 1 || p->io_seq[i].len < 1 || p->io_seq[i].dev < 0 || p->io_seq[i].dev >= tr->hdr.devices){
+            printf("Error: trace record %lld has an invalid I/O burst\n", tr->read);
+            exit(1);
         }
-        curr = curr->right;
     }
+    if(rec.io_cnt > 0){
+        p->io_burst_start = p->io_seq[0].gap;
+        p->io_burst_rem = p->io_seq[0].len;
+        p->io_dev = p->io_seq[0].dev;
+        p->io_next = 1;
+    }
+    else{
+        p->io_burst_start = -1;
+        p->io_burst_rem = 0;
+        p->io_dev = 0;
+        p->io_next = 0;
+    }
+    p->deadline = _deadline_of(tr->deadline_factor, rec.cpu_burst);
+    p->period = 0;
+    _reset_process(p);
+    tr->off += sizeof(IoBurst)*rec.io_cnt;
+    tr->last_arrival = rec.arrival;
+    tr->read++;
+    if(tr->off - tr->released > TRACE_RELEASE){
+        // pages behind the cursor are only needed again by the io_seq of long running processes,
+        // which just fault them back in from the file
+        size_t upto = tr->off & ~(size_t)(sysconf(_SC_PAGESIZE) - 1);
+        madvise((void*)(tr->map + tr->released), upto - tr->released, MADV_DONTNEED);
+        tr->released = upto;
+    }
+    return p;
+}
 
-    // only preempt if ready queue has a Process with higher priority than running_p
-    return (max_priority > running_priority) ? max_node->p : running_p;
+
+void close_trace(Trace* tr){
+    munmap((void*)tr->map, tr->size);
+    for(int i=0; i<tr->chunk_cnt; i++){
+        free(tr->chunk[i]);
+    }
+    free(tr->chunk);
+    free(tr->free_p);
+    free(tr);
 }
 
-void print_process_info(Process* p){
-    // to be used after create_process()
-    printf("\n[%d] Process Info\n==============\n", p->pid);
-    switch (p->state) {
-        case 0:
-            printf("State: new\n");
-            break;
-        case 1:
-            printf("State: ready\n");
-            break;
-        case 2:
-            printf("State: running\n");
-            break;
-        case 3:
-            printf("State: waiting\n");
-            break;
-        case 4:
-            printf("State: terminated\n");
-            break;
-        default:
-            printf("State: unknown\n");
-            break;
+
+static void _trace_write_rec(FILE* out, TraceHeader* hdr, Process* p){
+    /* append one record (and update the header counters) */
+    TraceRec rec = {p->arrival_time, p->pid, p->priority, p->cpu_burst_init, p->io_cnt};
+    fwrite(&rec, sizeof(TraceRec), 1, out);
+    fwrite(p->io_seq, sizeof(IoBurst), p->io_cnt, out);
+    hdr->count++;
+    if(p->io_cnt > hdr->max_io){
+        hdr->max_io = p->io_cnt;
+    }
+    for(int i=0; i<p->io_cnt; i++){
+        if(p->io_seq[i].dev + 1 > hdr->devices){
+            hdr->devices = p->io_seq[i].dev + 1;
+        }
     }
-    printf("Arrival_time: %d\n", p->arrival_time);
-    printf("Priority: %d\n", p->priority);
-    printf("CPU Burst Time (Initial): %d\n", p->cpu_burst_init);
-    printf("I/O Burst Time (Initial): %d\n", p->io_burst_rem);
-    printf("I/O Burst Start Time: %d\n", p->io_burst_start);
 }
 
 
-void print_queue(Queue *q){
-    // check if empty
-    if(q->head == NULL){
-        printf("Queue is empty\n");
-        return;
+int export_trace(Config* cfg, const char* trace_path){
+    /*
+    Write the processes create_process() generates for cfg as a binary trace (--export-trace)
+    */
+    FILE *out = fopen(trace_path, "wb");
+    if(out == NULL){
+        printf("Error: couldn't open %s\n", trace_path);
+        return 1;
     }
-    // print queue info
-    printf("Processes Count: %d\n", q->cnt);
-    
-    // print queue
-    Node *curr = q->head;
-    while (curr != NULL) {
-        printf("[%d]-->", curr->p->pid);
-        curr = curr->right;
+    Config gen = *cfg;
+    gen.trace_file = NULL;
+    gen.log_level = 0;
+    gen.timeline_file = NULL;
+    Table *tbl = create_table(&gen);
+    create_process(tbl, &gen);
+    TraceHeader hdr = {TRACE_MAGIC, TRACE_VERSION, 0, 0, 0};
+    fwrite(&hdr, sizeof(TraceHeader), 1, out);
+    for(int i=0; i<tbl->pool_cnt; i++){
+        _trace_write_rec(out, &hdr, tbl->new_pool[i]);
     }
-    printf("NULL\n\n");
+    fseek(out, 0, SEEK_SET);
+    fwrite(&hdr, sizeof(TraceHeader), 1, out);
+    fclose(out);
+    free_table(tbl);
+    printf("%lld processes written to %s\n", hdr.count, trace_path);
+    return 0;
 }
 
 
-void evaluate(Table* tbl, int algo, int size){
+int import_csv_trace(const char* csv_path, const char* trace_path){
     /*
-    Display evaluation info/metrics for the process in term_q
-    with the provided `pid`
-    if pid=0, it will display overview
-    if pid=-1, it will exit evaluation mode
-     */
-    int pid;
-    Queue* term_q = tbl->term_q;
+    Convert a CSV workload to a binary trace (--import-csv), one process per line, in arrival order:
+        pid,arrival,priority,cpu_burst[,io_gap,io_len,io_device]...
+    (io_gap: CPU clks before the I/O burst, counted from the previous one). Lines that don't start
+    with a digit (header, comments) are skipped. Streams line by line, so the CSV can be any size
+    */
+    FILE *in = fopen(csv_path, "r");
+    if(in == NULL){
+        printf("Error: couldn't open %s\n", csv_path);
+        return 1;
+    }
+    FILE *out = fopen(trace_path, "wb");
+    if(out == NULL){
+        printf("Error: couldn't open %s\n", trace_path);
+        fclose(in);
+        return 1;
+    }
+    TraceHeader hdr = {TRACE_MAGIC, TRACE_VERSION, 0, 0, 0};
+    fwrite(&hdr, sizeof(TraceHeader), 1, out);
 
-    printf("\n\n====START EVALUATION====\n");
-    // take user input for pid
-    while(pid != -1){
-        printf("<<Enter PID to evaluate (0: overview, -1: restart, -2: exit)>>\n");
-        printf("PID: ");
-        scanf(" %d", &pid); // consume newline
-        printf("--------------------------------------\n");
-        Node* curr = term_q->head;
-        if(pid == -1){
-            printf("\nExiting evaluation...\n");
-            break;
-        }
-        else if(pid == -2){
-            printf("\nExiting program...\n");
-            exit(0);
+    char *line = NULL;
+    size_t line_cap = 0;
+    long long line_no = 0, last_arrival = LLONG_MIN;
+    IoBurst *io = NULL;
+    int io_cap = 0;
+    int ret = 0;
+    while(getline(&line, &line_cap, in) > 0){
+        line_no++;
+        if(line[0] < '0' || line[0] > '9'){
+            continue;
         }
-        if(pid==0){ // overview
-            int ready_wait_time_sum = 0;
-            int io_wait_time_sum = 0;
-            int turnaround_time_sum = 0;
-            int wait_time_sum = 0;
-
-            int ready_wait_time_avg = 0;
-            int io_wait_time_avg = 0;
-            int turnaround_time_avg = 0;
-            int wait_time_avg = 0;
-            int num_process = term_q->cnt;
-
-            while(curr != NULL){
-                ready_wait_time_sum += curr->p->ready_wait_time;
-                io_wait_time_sum += curr->p->io_wait_time;
-                turnaround_time_sum += curr->p->turnaround_time;
-                curr = curr->right;
-            }
-            wait_time_sum = ready_wait_time_sum + io_wait_time_sum;
-            
-            ready_wait_time_avg = ready_wait_time_sum / num_process;
-            io_wait_time_avg = io_wait_time_sum / num_process;
-            turnaround_time_avg = turnaround_time_sum / num_process;
-            wait_time_avg = wait_time_sum / num_process;
-            switch (algo) {
-                case 0:
-                    printf("Algorithm: FCFS\n");
-                    break;
-                case 1:
-                    printf("Algorithm: SJF\n");
-                    break;
-                case 2:
-                    printf("Algorithm: SRTF (SJF with preemption)\n");
-                    break;
-                case 3:
-                    printf("Algorithm: Priority (no preemption)\n");
-                    break;
-                case 4:
-                    printf("Algorithm: Preemptive Priority\n");
-                    break;
-                case 5:
-                    printf("Algorithm: Round Robin\n");
-                    break;
+        long long v[4];
+        char *s = line, *end;
+        int n = 0;
+        for(; n<4; n++){
+            v[n] = strtoll(s, &end, 10);
+            if(end == s){
+                break;
             }
-            printf("Task Finished at %d\n\n", tbl->clk);
-            printf("Terminated Queue:\n");
-            print_queue(term_q);
-            printf("\nWait time: total=%d, avg=%d\n", wait_time_sum, wait_time_avg);
-            printf("Ready queue wait time: total=%d, avg=%d\n", ready_wait_time_sum, ready_wait_time_avg);
-            printf("Wait queue wait time: total=%d, avg=%d\n", io_wait_time_sum, io_wait_time_avg);
-            printf("Turnaround time: total=%d, avg=%d\n\n\n", turnaround_time_sum, turnaround_time_avg);
-
-            print_gannt_chart(size);
+            s = (*end == ',') ? end+1 : end;
         }
-        else{ // pid != 0
-            while(curr != NULL){    // search term_q for PID match
-                if(curr->p->pid == pid){
-                    printf("[%d] Evaluation\n", pid);
-                    printf("--------------------\n");
-                    printf("Wait time: %d (ready: %d, wait:%d)\n",
-                    curr->p->ready_wait_time + curr->p->io_wait_time, curr->p->ready_wait_time, curr->p->io_wait_time);
-                    printf("Turnaround time: %d (Arrive:%d, Terminate:%d)\n",
-                    curr->p->turnaround_time, curr->p->arrival_time, curr->p->finish_time);
-                    printf("Priority: %d\n\n\n", curr->p->priority);
-                    break;  // break out of while(curr != NULL)
+        Process p;
+        p.io_cnt = 0;
+        while(n == 4){
+            long long b[3];
+            int k = 0;
+            for(; k<3; k++){
+                b[k] = strtoll(s, &end, 10);
+                if(end == s){
+                    break;
                 }
-                curr = curr->right;
+                s = (*end == ',') ? end+1 : end;
             }
-            if(curr == NULL){
-                printf("Error: PID not found\n\n\n");
+            if(k == 0){
+                break;
             }
-        } // else: display evaluation info for process with pid
+            if(k != 3 || b[0] < 1 || b[1] < 1 || b[2] < 0){
+                n = -1;
+                break;
+            }
+            if(p.io_cnt == io_cap){
+                io_cap = (io_cap == 0) ? 16 : io_cap*2;
+                io = (IoBurst*)realloc(io, sizeof(IoBurst)*io_cap);
+            }
+            io[p.io_cnt].gap = (int)b[0];
+            io[p.io_cnt].len = (int)b[1];
+            io[p.io_cnt].dev = (int)b[2];
+            p.io_cnt++;
+        }
+        if(n != 4 || v[3] < 1){
+            printf("Error: %s:%lld: expected pid,arrival,priority,cpu_burst[,io_gap,io_len,io_device]...\n", csv_path, line_no);
+            ret = 1;
+            break;
+        }
+        if(v[2] < 0 || v[2] > MAX_PRIORITY){
+            printf("Error: %s:%lld: priority must be 0 (none) ~ %d\n", csv_path, line_no, MAX_PRIORITY);
+            ret = 1;
+            break;
+        }
+        if(v[1] < last_arrival){
+            printf("Error: %s:%lld: not in arrival order (sort it first, e.g. sort -t, -k2,2n)\n", csv_path, line_no);
+            ret = 1;
+            break;
+        }
+        last_arrival = v[1];
+        p.pid = (int)v[0];
+        p.arrival_time = v[1];
+        p.priority = (int)v[2];
+        p.cpu_burst_init = (int)v[3];
+        p.io_seq = io;
+        _trace_write_rec(out, &hdr, &p);
     }
+    free(line);
+    free(io);
+    fclose(in);
+    if(ret != 0){
+        // no partial trace: --trace would replay it without complaint
+        fclose(out);
+        remove(trace_path);
+        return ret;
+    }
+    fseek(out, 0, SEEK_SET);
+    fwrite(&hdr, sizeof(TraceHeader), 1, out);
+    fclose(out);
+    printf("%lld processes written to %s\n", hdr.count, trace_path);
+    return 0;
 }
 
 
-void print_gannt_chart(int size){
-    
-    int curr_pid = 0;
-    int next_pid = 0;   // when curr != next, process switched
-    int i = 0;
-    
-    printf("====Gannt Chart====\n");
-    printf("(CPU burst starts this clock)---[Process]---(next Process starts this clock)\n\n");
+// comparison of algorithms on one shared workload
 
-    // gannt chart
-    printf("(0)");
-    while(1){
-        curr_pid = gannt[i];
-        next_pid = gannt[i+1];
-        if(curr_pid != next_pid){
-            if(curr_pid == -1){
-                printf("---CPU IDLE---(%d)", i+1);
-            }
-            else{
-                printf("---[PID: %d]---(%d)", curr_pid, i+1);
-            }
+Workload* create_workload(Config* cfg){
+    /*
+    Create the processes of cfg once (generated, or every record of cfg->trace_file) for runs that only read them.
+    Sets cfg->num_process (and num_devices for a trace) like create_table() does
+    */
+    Workload *wl = (Workload*)calloc(1, sizeof(Workload));
+    if(cfg->trace_file != NULL){
+        wl->trace = open_trace(cfg->trace_file, cfg);
+        wl->count = cfg->num_process;
+        wl->proc = (Process*)malloc(sizeof(Process)*wl->count);
+        wl->order = (int*)malloc(sizeof(int)*wl->count);
+        for(int i=0; i<wl->count; i++){
+            // records are in arrival order, their io_seq keeps pointing into the mapping
+            Process *p = _trace_read(wl->trace);
+            wl->proc[i] = *p;
+            wl->order[i] = i;
+            _trace_free_slot(wl->trace, p);
         }
-        i++;
-        if(i==size){
-            break;
+        rng_seed(&wl->rng, (uint64_t)cfg->seed);
+    }
+    else{
+        Config gen = *cfg;
+        gen.log_level = 0;
+        gen.timeline_file = NULL;
+        gen.num_cores = 1;
+        Table *tbl = create_table(&gen);
+        create_process(tbl, &gen);
+        wl->count = tbl->pool_cnt;
+        wl->proc = tbl->proc_block;
+        wl->io_block = tbl->io_block;
+        wl->order = (int*)malloc(sizeof(int)*wl->count);
+        for(int i=0; i<wl->count; i++){
+            wl->order[i] = (int)(tbl->new_pool[i] - tbl->proc_block);
         }
+        wl->rng = tbl->rng;
+        tbl->proc_block = NULL;
+        tbl->io_block = NULL;
+        free_table(tbl);
     }
-    // finish clock
-    printf("---[PID: %d]---(%d)", gannt[i], i);
-    printf("\n\n");
+    wl->num_devices = (cfg->num_devices > 1) ? cfg->num_devices : 1;
+    return wl;
 }
 
 
-void display_config(Config* cfg){
-    /* prints Config */
-    printf("\n\n==============\n");
-    printf("<<Config>>\n");
-    printf("==============\n");
-    printf("Number of processes: %d\n", cfg->num_process);
-    printf("Scheduling algorithm: ");
-    switch (cfg->algo) {
-        case 0:
-            printf("FCFS\n");
-            break;
-        case 1:
-            printf("SJF\n");
-            break;
-        case 2:
-            printf("SRTF (SJF with preemption)\n");
-            break;
-        case 3:
-            printf("Priority (no preemption)\n");
-            break;
-        case 4:
-            printf("Preemptive Priority\n");
-            break;
-        case 5:
-            printf("Round Robin\n");
-            printf("Time quantum: %d\n", cfg->quantum);
-            break;
+Table* workload_table(const Workload* wl, Config* cfg){
+    /*
+    A Table ready to simulate wl with cfg: the processes are copied from wl (memcpy of the initial records,
+    the only per-run process state), new_pool follows wl->order and the I/O bursts are not copied
+    */
+    Config run = *cfg;
+    run.trace_file = NULL;
+    run.num_devices = wl->num_devices;
+    Table *tbl = create_table(&run);
+    tbl->proc_block = (Process*)malloc(sizeof(Process)*wl->count);
+    memcpy(tbl->proc_block, wl->proc, sizeof(Process)*wl->count);
+    tbl->new_pool = (Process**)malloc(sizeof(Process*)*wl->count);
+    for(int i=0; i<wl->count; i++){
+        Process *p = &tbl->proc_block[wl->order[i]];
+        p->node.p = p;
+        tbl->new_pool[i] = p;
     }
-    printf("\n\n");
+    tbl->pool_cnt = wl->count;
+    tbl->rng = wl->rng;
+    return tbl;
 }
 
 
-void edit_config(Config* cfg){
-    display_config(cfg);
-    printf("\n\n<<Edit Config?>> (y/n) : ");
-    char c;
-    scanf(" %c", &c);
+void simulate_workload(const Workload* wl, Config* cfg, Eval* ev, double* wall_sec){
+    /* simulate() on a shared workload, safe to call from several threads at once */
+    Table *tbl = workload_table(wl, cfg);
+    *wall_sec = _run(tbl, cfg);
+    compute_eval(tbl, ev);
+    free_table(tbl);
+}
 
-    if(c == 'y'){
-        printf("\n<<Edit Config>>\n\n");
-        printf("<<Enter number of processes>> (MAX=20): ");
-        scanf(" %d", &cfg->num_process);
-        printf("\n<<Enter scheduling algorithm>> (0~5)\n");
-        printf("0: FCFS, 1: SJF, 2: SRTF, 3: Priority, 4: Preemptive Priority, 5: Round Robin\n");
-        printf("Algorithm: ");
-        scanf(" %d", &cfg->algo);
-        if(cfg->algo == 5){
-            printf("<<Enter time quantum>> (default=5): ");
-            scanf(" %d", &cfg->quantum);
+
+void free_workload(Workload* wl){
+    free(wl->proc);
+    free(wl->io_block);
+    free(wl->order);
+    if(wl->trace != NULL){
+        close_trace(wl->trace);
+    }
+    free(wl);
+}
+
+
+#define CMP_METRICS 13
+
+static double _cmp_metric(Eval* ev, int m){
+    /* metric m of the comparison table (see run_compare()) */
+    double n = (ev->num_process > 0) ? ev->num_process : 1;
+    switch(m){
+        case 0: return ev->num_process;
+        case 1: return ev->wait_sum/n;
+        case 2: return ev->ready_wait_sum/n;
+        case 3: return ev->turnaround_sum/n;
+        case 4: return (double)ev->turnaround.p95;
+        case 5: return (double)ev->turnaround.p99;
+        case 6: return ev->response_sum/n;
+        case 7: return (double)ev->response.p95;
+        case 8: return (double)ev->finish_clk;
+        case 9: return ev->utilization;
+        case 10: return ev->fairness;
+        case 11: return (double)ev->dispatches;
+        default: return (double)ev->deadline_misses;
+    }
+}
+
+
+int run_compare(Config* base, const char* algos, int num_workers, bool header){
+    /*
+    Compare algorithms on one workload (--compare): the processes are created once (create_workload())
+    and every algorithm runs on its own copy of them concurrently, on `num_workers` threads (0: one per
+    algorithm). Prints one table of the evaluation metrics with the winner of each one.
+    Priorities are drawn if any of the algorithms uses them, so that all of them see the same processes
+    */
+    const char* names[CMP_METRICS] = {"terminated", "wait_avg", "ready_wait_avg", "turnaround_avg", "turnaround_p95",
+                                      "turnaround_p99", "response_avg", "response_p95", "finish_clk", "utilization",
+                                      "fairness", "dispatches", "deadline_misses"};
+    const bool higher[CMP_METRICS] = {true, false, false, false, false, false, false, false, false, true, true, false, false};
+    const int decimals[CMP_METRICS] = {0, 3, 3, 3, 0, 0, 3, 0, 0, 4, 4, 0, 0};
+    int algo_v[16];
+    int na = _parse_list(algos, algo_v, 16);
+    if(na < 1){
+        printf("Error: invalid --compare list\n");
+        return 1;
+    }
+    Config cfg = *base;
+    cfg.use_priority = false;
+    for(int a=0; a<na; a++){
+        if(algo_v[a] < 0 || algo_v[a] > MAX_ALGO){
+            printf("Error: invalid --compare list\n");
+            return 1;
         }
-        // use priority?
-        if(cfg->algo == 3 || cfg->algo == 4){
-            cfg->use_priority = true;
+        cfg.use_priority = cfg.use_priority || _uses_priority(algo_v[a]);
+    }
+    cfg.log_level = 0;
+    cfg.verbose = false;
+    cfg.log_file = NULL;
+    cfg.timeline_file = NULL;
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    Workload *wl = create_workload(&cfg);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double gen_sec = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec)*1e-9;
+
+    Sweep sw;
+    sw.tasks = (SweepTask*)malloc(sizeof(SweepTask)*na);
+    sw.num_tasks = na;
+    for(int a=0; a<na; a++){
+        sw.tasks[a].cfg = cfg;
+        sw.tasks[a].cfg.algo = algo_v[a];
+        sw.tasks[a].wl = wl;
+    }
+    long long steals;
+    double wall_sec = _run_pool(&sw, (num_workers > 0) ? num_workers : na, &steals);
+
+    // winner of each metric (ties: every algorithm that has the best value), rows that can't differ are left out
+    bool show[CMP_METRICS];
+    int best[CMP_METRICS];
+    for(int m=0; m<CMP_METRICS; m++){
+        best[m] = 0;
+        for(int a=1; a<na; a++){
+            double v = _cmp_metric(&sw.tasks[a].ev, m), b = _cmp_metric(&sw.tasks[best[m]].ev, m);
+            best[m] = (higher[m] ? v > b : v < b) ? a : best[m];
         }
-        else{
-            cfg->use_priority = false;
+        show[m] = true;
+    }
+    show[0] = false;
+    for(int a=0; a<na; a++){
+        show[0] = show[0] || sw.tasks[a].ev.num_process != wl->count;
+    }
+    show[12] = sw.tasks[0].ev.deadline_jobs > 0;
+
+    char winner[CMP_METRICS][16*8];
+    for(int m=0; m<CMP_METRICS; m++){
+        double b = _cmp_metric(&sw.tasks[best[m]].ev, m);
+        int ties = 0;
+        winner[m][0] = '\0';
+        for(int a=0; a<na; a++){
+            if(_cmp_metric(&sw.tasks[a].ev, m) == b){
+                if(ties++ > 0){
+                    strcat(winner[m], "/");
+                }
+                strcat(winner[m], _algo_name(algo_v[a], false));
+            }
         }
-        // random seed?
-        printf("\n<<Use random seed?>> (y/n): ");
-        scanf(" %c", &c);
-        if(c == 'y'){
-            printf("\n<<Enter random seed>> (int 1~99): ");
-            int seed;
-            scanf(" %d", &seed);
-            srand(seed);
+        if(ties == na && na > 1){
+            strcpy(winner[m], "-");
         }
-        printf("\n<<Config updated>>\n");
-        display_config(cfg);
     }
-    else{
-        printf("\n\n<<Using default config>>\n");
+
+    switch(cfg.format){
+        case 1: // json
+            printf("{\"num_process\":%d,\"seed\":%d,\"quantum\":%d,\"engine\":\"%s\",\"source\":\"%s\",\"runs\":[",
+                   wl->count, cfg.seed, cfg.quantum, (cfg.engine == 1) ? "event" : "tick",
+                   (wl->trace != NULL) ? "trace" : "generated");
+            for(int a=0; a<na; a++){
+                printf("%s{\"algo\":\"%s\"", (a > 0) ? "," : "", _algo_name(algo_v[a], false));
+                for(int m=0; m<CMP_METRICS; m++){
+                    printf(",\"%s\":%.*f", names[m], decimals[m], _cmp_metric(&sw.tasks[a].ev, m));
+                }
+                printf(",\"wall_sec\":%.6f}", sw.tasks[a].wall_sec);
+            }
+            printf("],\"winner\":{");
+            for(int m=0, k=0; m<CMP_METRICS; m++){
+                if(show[m]){
+                    printf("%s\"%s\":\"%s\"", (k++ > 0) ? "," : "", names[m], winner[m]);
+                }
+            }
+            printf("}}\n");
+            break;
+        case 2: // csv
+            if(header){
+                printf("metric");
+                for(int a=0; a<na; a++){
+                    printf(",%s", _algo_name(algo_v[a], false));
+                }
+                printf(",winner\n");
+            }
+            for(int m=0; m<CMP_METRICS; m++){
+                if(!show[m]){
+                    continue;
+                }
+                printf("%s", names[m]);
+                for(int a=0; a<na; a++){
+                    printf(",%.*f", decimals[m], _cmp_metric(&sw.tasks[a].ev, m));
+                }
+                printf(",%s\n", winner[m]);
+            }
+            break;
+        default: // text
+            printf("Comparison on one workload: %d processes, seed: %d (%s), quantum: %d, engine: %s\n",
+                   wl->count, cfg.seed, (wl->trace != NULL) ? cfg.trace_file : "generated", cfg.quantum,
+                   (cfg.engine == 1) ? "event" : "tick");
+            printf("%-16s", "metric");
+            for(int a=0; a<na; a++){
+                printf(" %12s", _algo_name(algo_v[a], false));
+            }
+            printf("  winner\n");
+            for(int m=0; m<CMP_METRICS; m++){
+                if(!show[m]){
+                    continue;
+                }
+                printf("%-16s", names[m]);
+                for(int a=0; a<na; a++){
+                    printf(" %12.*f", decimals[m], _cmp_metric(&sw.tasks[a].ev, m));
+                }
+                printf("  %s\n", winner[m]);
+            }
+            break;
     }
+    fprintf(stderr, "compare: %d simulations on %d threads in %.3f sec (%lld stolen), workload created once in %.3f sec\n",
+            na, sw.num_workers, wall_sec, steals, gen_sec);
+    free(sw.tasks);
+    free_workload(wl);
+    return 0;
 }
 
 
-int main(){
+int main(int argc, char** argv){
+    if(argc > 1){
+        return run_batch(argc, argv);
+    }
     while(1){
         // set default config
-        srand(98);
         Config cfg = {
             .rand_pid = true,   // can't modify
             .rand_arrival = true,   // can't modify
@@ -876,8 +6378,44 @@ int main(){
             .rand_cpu_burst = true, // can't modify
             .rand_io_burst = true,  // can't modify
             .num_process = 5,
-            .algo = 5,  // 0: FCFS, 1: SJF, 2: SRTF, 3: Priority, 4: Preemptive Priority, 5: RR
-            .quantum = 5
+            .algo = 5,  // RR (see POLICIES)
+            .quantum = 5,
+            .mlfq_levels = 3,   // MLFQ: quanta 5, 10, 20
+            .mlfq_quanta = {0},
+            .mlfq_boost = 100,
+            .cfs_latency = 12,  // CFS: the minimum granularity is the quantum
+            .deadline_factor = 0,   // EDF: no deadlines unless edit_config() asks for them
+            .num_tasks = 0,
+            .task_util = 0.8,
+            .task_deadline = 1,
+            .admit = false,
+            .tickets = {0},     // lottery/stride: the CFS weights
+            .max_time = 0,  // 0: no limit
+            .ready_q_type = 1,  // 0: linked list, 1: heap, 2: key array (SIMD)
+            .engine = 0, // 0: tick loop, 1: event-driven
+            .num_cores = 1,
+            .num_devices = 1,
+            .io_bursts = 1,
+            .trace_file = NULL,
+            .arrival_dist = 0,
+            .arrival_mean = 12.5,
+            .burst_dist = 0,
+            .burst_mean = 10,
+            .burst_shape = 1,
+            .interactive_frac = 0.7,
+            .prio_weights = {0},
+            .keep_gannt = true,
+            .profile = false,
+            .generic_loop = false,
+            .interactive = true,
+            .log_level = 2, // log everything, printed as it happens
+            .verbose = true,
+            .log_size = 4096,
+            .log_file = NULL,
+            .timeline_file = NULL,
+            .timeline_binary = false,
+            .seed = 98,
+            .format = 0
         };
         
         // take user input for config
@@ -887,7 +6425,7 @@ int main(){
         Table *tbl = create_table(&cfg);
         
         // create processes, store them in new_pool (tbl->new_pool)
-        tbl->new_pool = create_process(&cfg);
+        create_process(tbl, &cfg);
 
         printf("\n\n====TASK START====\n");
         // print process info
@@ -906,34 +6444,20 @@ int main(){
 
         printf("\n\n====LOGS====\n");
         // loop
-        while(tbl->clk < MAX_TIME){
-            if(tbl->clk % 20 == 0){
-                printf("\nDue to Ubuntu Server terminal's scroll constraint, only 20 cycles of log will be displayed at a time.\n");
-                printf("Input any character to continue...\n");
-                char c;
-                scanf(" %c", &c);
-                printf("\n\n");
-            }
-            // add processes that arrived to ready_queue
-            arrived_to_ready(tbl, cfg.num_process);
-            wait_to_ready(tbl, cfg.algo);
-            // schedule, compute, enqueue, dequeue processes
-            io_service(tbl, cfg.algo);
-            CPU(tbl, cfg.algo, cfg.quantum);
-
-            // check if all processes are terminated
-            if(tbl->term_q->cnt == cfg.num_process){
-                printf("<@%d> COMPLETE: All processes are terminated\n====LOG END====\n", tbl->clk);
-                break;
-            }
-
-            // increment wait time for all processes in wait queue
-            update_wait_time(tbl);
-
-            tbl->clk++;
+        if(tbl->cores != NULL){
+            run_multi(tbl, &cfg);
+        }
+        else if(cfg.engine == 1){
+            run_event(tbl, &cfg);
+        }
+        else{
+            run_tick(tbl, &cfg);
+        }
+        if(tbl->term_q->cnt != cfg.num_process){
+            LOG_EVENT(tbl, tbl->clk, LOG_STOP, 0, 0, 0, 0, 0, cfg.num_process - tbl->term_q->cnt);
         }
         // test evalutate per pid
-        evaluate(tbl, cfg.algo, tbl->clk);
+        evaluate(tbl, cfg.algo);
     }
     return 0;
 }
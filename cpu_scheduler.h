@@ -1,6 +1,8 @@
 // defines variables and data structures that are used in cpu_scheduler.c
 
 /* STRUCTS
+Table: simulation context. Everything a simulation changes hangs off it (queues, gannt chart, RNG, log),
+       so independent Tables can be simulated concurrently
 Status: keeps track of processes and their states
 Process: holds information about a process
 Queue: priority queue. has 4 queues (one for each priority)
@@ -14,13 +16,66 @@ Config: keeps track of current configuration
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
 
-#ifndef MAX_PROCESS
-#define MAX_PROCESS 20
-#endif
 
+// event log record types (LogRec.type). LOG_IDLE and LOG_IDLE_SPAN are only logged at log level 2
+#define LOG_ARRIVE          0   // pid arrived to ready queue
+#define LOG_IO_COMPLETE     1   // pid finished I/O (preemptive algos)
+#define LOG_IO_COMPLETE_NP  2   // pid finished I/O (non-preemptive algos)
+#define LOG_READY           3   // pid moved from I/O to ready queue
+#define LOG_DISPATCH        4   // pid to CPU
+#define LOG_DISPATCH_IO     5   // pid to CPU straight from I/O
+#define LOG_DISPATCH_PRIO   6   // pid to CPU, aux[0]: priority
+#define LOG_DISPATCH_PPRIO  7   // pid to CPU, aux[0]: priority (preemptive priority)
+#define LOG_PREEMPT         8   // pid (aux[0] clk left) replaces pid2 (aux[1] clk left)
+#define LOG_PREEMPT_PRIO    9   // pid (aux[0]: priority, aux[1]: clk left) replaces pid2 (aux[2]: priority, arg: clk left)
+#define LOG_RR_RENEW        10  // pid (aux[0] clk left) keeps the CPU for another quantum
+#define LOG_RR_SWITCH       11  // pid (aux[0] clk left) replaces pid2 (aux[1] clk left)
+#define LOG_TERMINATE       12  // pid to term queue
+#define LOG_WAIT            13  // pid to wait queue, aux[0]: I/O burst
+#define LOG_IO_START        14  // pid starts I/O, aux[0]: I/O burst
+#define LOG_COMPLETE        15  // all processes terminated
+#define LOG_STOP            16  // max_time reached, arg: processes not terminated
+#define LOG_IDLE            17  // CPU idle for one clk, aux[0]: 0: CPU and I/O idle, 1: CPU idle (RR), 2: CPU idle
+#define LOG_IDLE_SPAN       18  // CPU idle for arg clks (event engine)
+#define LOG_MIGRATE         19  // pid stolen from core aux[0] by core aux[1]
+#define LOG_DEMOTE          20  // pid used up its allotment, aux[0]: new MLFQ level
+#define LOG_BOOST           21  // every process back to MLFQ level 0, pid: running process
+#define LOG_PREEMPT_MLFQ    22  // pid (aux[0]: level) replaces pid2 (aux[1]: level)
+#define LOG_PREEMPT_CFS     23  // pid (arg: vruntime behind pid2) replaces pid2
+#define LOG_PREEMPT_EDF     24  // pid (arg: absolute deadline) replaces pid2 (aux[0]: its deadline is that much later)
+#define LOG_DEADLINE_MISS   25  // pid finished arg clks after its deadline
+#define LOG_LOTTERY         26  // pid (aux[0]: its tickets) won the draw among arg tickets, pid2 to ready queue (or pid2 == pid)
+#define LOG_PREEMPT_STRIDE  27  // pid (arg: pass behind pid2) replaces pid2
 
 // structs
+typedef struct Node{
+    /*
+    Queue (linked list) of processes of the same priority
+
+    Processes enter the queue from left to right (i.e. left node entered the queue earlier)
+
+    Every Process embeds its own Node (a process is in at most one queue at a time),
+    so enqueue()/dequeue() never allocate or search.
+    */
+    struct Process *p;
+    struct Node *left;  // left node entered the queue earlier
+    struct Node *right; // right node entered the queue later
+    struct Queue *q;    // queue the node is currently linked into (NULL if none)
+
+}Node;
+
+
+typedef struct IoBurst{
+    /* one I/O burst of a process */
+    int gap;    // CPU clks to run (since the start, or the end of the previous I/O burst) before this burst
+    int len;    // I/O clks
+    int dev;    // target device (index in DeviceSet.dev)
+}IoBurst;
+
+
 typedef struct Process{
     // initial data
     int pid;             // 1001 ~ 9999
@@ -29,50 +84,190 @@ typedef struct Process{
     
     int cpu_burst_init;  // initial cpu_burst_time
     int cpu_burst_rem;   // remaining cpu burst
-    int arrival_time;    // 0 ~ MAX_ARRIVAL_TIME, default is global process_cnt
-    int io_burst_start;  // # of cpu bursts after which io must be performed (1 ~ cpu_burst_init -1)
-    int io_burst_rem;    // remaining io burst. Up to 1/2 of cpu burst time (1 ~ cpu_burst_init/2)
+    long long arrival_time; // 0 ~ MAX_ARRIVAL_TIME, default is global process_cnt
+    int io_burst_start;  // # of cpu bursts after which io must be performed (1 ~ cpu_burst_init -1), -1: no more I/O
+    int io_burst_rem;    // length of the current io burst. Up to 1/2 of cpu burst time (1 ~ cpu_burst_init/2)
+    int io_dev;          // device of the current io burst
+    IoBurst* io_seq;     // all io bursts in order (io_burst_start/rem/dev hold io_seq[io_next-1])
+    int io_cnt;          // length of io_seq
+    int io_next;         // next burst to load when the current one is done
 
     // for evaluation()
-    int ready_wait_time;
-    int io_wait_time;
-    int turnaround_time;
-    int finish_time;
+    long long ready_wait_time;
+    long long io_wait_time;
+    long long turnaround_time;
+    long long finish_time;
+    long long first_run;    // clk of the first dispatch (-1: not dispatched yet), response time = first_run - arrival_time
+    long long q_enter_clk;  // clk at which the process entered its current queue (wait time is added on dequeue)
+
+    // for heap ready queues (Queue.type != 0)
+    int heap_idx;        // position in Queue.heap (-1 if not in a heap/key array)
+    int core;            // core whose ready queue the process belongs to (multi-core, -1: not arrived)
+    long long q_seq;     // enqueue order, breaks ties so that the earlier process wins
+
+    // for the multi-level feedback queue (Queue.type 5)
+    int level;           // MLFQ level, 0 is the highest
+    int slice;           // clks left of the allotment at this level (-1: the whole quantum of the level)
+    long long epoch;     // priority boosts done when level was set (older than Queue.epoch: back to level 0)
+
+    // for the fair-share scheduler (Queue.type 6)
+    long long vruntime;  // CPU time weighted by priority (CFS_WEIGHT_0 / weight per clk), -1: not placed yet
+
+    // for deadline scheduling (Queue.type 7)
+    int deadline;        // relative deadline, met if the process finishes before arrival_time + deadline (0: none)
+    int period;          // period of the periodic task the process is a job of (0: aperiodic)
+
+    // for proportional share (Queue.type 8, 9)
+    int tickets;         // tickets while runnable (Queue.tickets_of its priority, 0: tickets not used)
+    long long pass;      // stride: pass value, STRIDE1 / tickets per clk on the CPU (-1: not placed yet)
+    long long ent_mark;  // Stats.ticket_clock when the process last became runnable
+    double entitled;     // CPU clks its tickets entitled it to while it was runnable
+
+    Node node;           // intrusive list node (linked list queues)
 }Process;
 
 
+#define SEL_SAMPLE 64           // profiled queues time one in SEL_SAMPLE selections
+#define MAX_PRIORITY 4          // priorities are 1 (highest) ~ MAX_PRIORITY
+#define MLFQ_MAX_LEVELS 64      // levels of a multi-level queue (one bit each in Queue.bitmap)
+
 typedef struct Queue{
-    /* One dimensional queue (linked list) with no priority*/
+    /* One dimensional queue (linked list) with no priority,
+    or an indexed binary heap (type 1, 2) for SJF/SRTF/priority selection */
     struct Node *head;
     struct Node *tail;
     int cnt;
+
+    int type;               // 0: linked list (FIFO), 1: heap on cpu_burst_rem, 2: heap on priority
+                            // 3: key array on cpu_burst_rem, 4: key array on priority (SIMD scan)
+                            // 5: multi-level feedback queue, one list per level (MLFQ)
+                            // 6: heap on vruntime (CFS), 7: heap on absolute deadline (EDF)
+                            // 8: ticket array with a Fenwick tree (lottery), 9: heap on pass (stride)
+    struct Process **heap;  // heap array (type 1, 2, 6, 7, 9), process array (type 3, 4, 8)
+    int *key;               // type 3, 4: selection key of heap[i] (cpu_burst_rem, or -priority), contiguous for SIMD
+    long long *kseq;        // type 3, 4: Process.q_seq of heap[i]
+    int cap;                // allocated length of heap
+    long long seq;          // number of processes enqueued so far (next Process.q_seq)
+    int allocs;             // number of times the heap array had to grow
+
+    long long *clk;         // clock used to time how long processes stay (NULL: not timed)
+    int acct;               // time spent is added to: 0: nothing, 1: ready_wait_time, 2: io_wait_time
+
+    struct Queue *lv;       // type 5: FIFO list of each level
+    int *lq;                // type 5: time quantum of each level
+    int levels;             // type 5: number of levels
+    uint64_t bitmap;        // type 5: bit i is set if lv[i] is not empty
+    int boost;              // type 5: clks between priority boosts (0: never)
+    long long epoch;        // type 5: priority boosts applied to lv so far (see mlfq_top())
+
+    long long min_vruntime; // type 6: never decreasing smallest vruntime of the running and queued processes
+    long long credit;       // type 6: a process waking up is placed at most this far behind min_vruntime
+
+    int tickets_of[MAX_PRIORITY+1]; // type 8, 9: tickets of each priority (index 0: DEFAULT_PRIORITY)
+    long long *fen;         // type 8: Fenwick tree over the tickets of heap[0 ~ cnt-1] (fen[1 ~ cap])
+    long long tickets;      // type 8: tickets in the queue
+    long long global_pass;  // type 9: never decreasing smallest pass of the running and queued processes
+
+    bool prof;              // count _SJF()/_PRIO()/_MLFQ()/_TOP()/_LOTTERY() calls and time one in SEL_SAMPLE of them (Config.profile)
+    long long sel_calls;
+    long long sel_timed;    // calls that were timed
+    long long sel_ns;       // time spent in the timed calls
 }Queue;
 
+typedef struct Segment{
+    /* one run of consecutive clks with the same process on the CPU */
+    long long start;    // first clk of the segment
+    long long end;      // clk right after the segment
+    int pid;            // -1 if CPU was idle
+}Segment;
+
+
+typedef struct Timeline{
+    /* run-length encoded gannt chart: one Segment per CPU burst/idle period */
+    Segment* seg;
+    int cnt;
+    int cap;
+    bool tail_only;     // only keep the last Segment in seg[0] (cnt still counts all of them)
+    long long busy;     // clks with a process on the CPU
+    struct TimelineOut* out;    // segments are exported here as they end (NULL: no export)
+    int track;          // core of this chart in the export
+}Timeline;
+
+
+typedef struct Rng{
+    /* xoshiro256** state (seeded with splitmix64 by rng_seed()) */
+    uint64_t s[4];
+}Rng;
+
+
+typedef struct Task{
+    /* a periodic task: a job of wcet CPU clks is released every period clks, each due deadline clks later */
+    int wcet;
+    int period;
+    int deadline;
+}Task;
+
+
 typedef struct Table{
     /* Status Table */
-    Process** new_pool;     // new
+    Process** new_pool;     // new (sorted by arrival_time)
+    int pool_cnt;           // number of processes in new_pool
+    Process* proc_block;    // all processes, allocated as one block by create_process()
+    IoBurst* io_block;      // io bursts of all processes (Process.io_seq points into it)
+    int next_arrival;       // index of the first process in new_pool that has not arrived yet
     struct Queue* ready_q;  // ready
-    struct Queue* wait_q;   // waiting/blocked
     struct Queue* term_q;   // terminated
+    struct DeviceSet* io;   // I/O devices, each with its own wait queue
+    struct Trace* trace;    // trace replay: processes are streamed from here instead of new_pool (NULL: new_pool)
     Process* running_p;     // Process currently running
-    Process* io_p;          // Process currently performing io
-    int clk;                // current time
+    long long clk;          // current time
     int quantum;            // time quantum for RR
-}Table;
 
+    long long allocs;       // allocations made while simulating (should stop growing after warm-up)
+    long long alloc_clk;    // clk of the last allocation
 
-typedef struct Node{
-    /*
-    Queue (linked list) of processes of the same priority
+    struct EventLog* log;   // event log (NULL: no logging)
+    struct TimelineOut* tl_out; // timeline export (Config.timeline_file, NULL: off)
+    Timeline gannt;         // gannt chart of this simulation
+    Rng rng;                // random number generator of this simulation (Config.seed)
+    struct Stats* stats;    // turnaround/wait/response histograms (shared by the cores)
 
-    Processes enter the queue from left to right (i.e. left node entered the queue earlier)
-    */
-    struct Process *p;
-    struct Node *left;  // left node entered the queue earlier
-    struct Node *right; // right node entered the queue later
+    struct Table** cores;   // multi-core: one Table per core (NULL if num_cores == 1)
+    int num_cores;
+    int core_id;            // index in cores of the owner Table (-1: not a core)
+    long long migrations;   // processes moved between cores by work stealing
+    long long dispatches;   // processes put on the CPU (dispatch, preemption, RR switch, straight from I/O)
+}Table;
 
-}Node;
 
+// scheduling policies (Config.algo), in order of id:
+//   X(algo, name, label, title, charge, timers, preemptive, priority, quantum, queue)
+//   label/title:        short name (summaries, csv, json) and long name (interactive)
+//   _pick_<name>():     select/preempt running_p for the clk (the schedule step of CPU())
+//   _charge_<charge>(): account clks run by running_p (quantum, allotment, vruntime, pass)
+//   _timers_<timers>(): events of the event engine that follow from the running process
+//   priority:           processes get random priorities (Config.use_priority)
+//   quantum:            Config.quantum is used (sweeps and benchmarks try every --quanta value)
+//   queue:              Queue.type of the ready queue (1, 2: only with Config.ready_q_type 1, key arrays with 2)
+// a new algorithm is its hooks and one line here
+#define POLICIES(X) \
+    X(0, fcfs, "FCFS", "FCFS", none, none, false, false, false, 0) \
+    X(1, sjf, "SJF", "SJF", none, none, false, false, false, 1) \
+    X(2, srtf, "SRTF", "SRTF (SJF with preemption)", none, none, true, false, false, 1) \
+    X(3, prio, "PRIO", "Priority (no preemption)", none, none, false, true, false, 2) \
+    X(4, pprio, "PPRIO", "Preemptive Priority", none, none, true, true, false, 2) \
+    X(5, rr, "RR", "Round Robin", quantum, quantum, true, false, true, 0) \
+    X(6, mlfq, "MLFQ", "Multi-level feedback queue", mlfq, mlfq, true, false, true, 5) \
+    X(7, cfs, "CFS", "CFS (fair share)", cfs, cfs, true, true, true, 6) \
+    X(8, edf, "EDF", "EDF (earliest deadline first)", none, none, true, false, false, 7) \
+    X(9, lottery, "LOTTERY", "Lottery", quantum, quantum, true, true, true, 8) \
+    X(10, stride, "STRIDE", "Stride", stride, quantum, true, true, true, 9)
+
+#define _POLICY_COUNT(id, name, label, title, charge, timers, preempt, prio, quantum, queue) +1
+#define MAX_ALGO (POLICIES(_POLICY_COUNT) - 1)  // highest Config.algo
+#define MAX_TASKS GEN_BATCH     // tasks of a periodic task set
+#define CFS_WEIGHT_0 1024       // CFS weight of the default priority (nice 0)
+#define GEN_BATCH 1024          // processes generated at a time by the statistical generators
 
 typedef struct Config{
     bool rand_pid;      // false: (default) increments from 1001
@@ -87,35 +282,490 @@ typedef struct Config{
 
     int num_process;    // number of processes to generate
 
-    int algo;           // 0: FCFS, 1: SJF, 2: SJF w/ preemption, 3: PRIO w/o preemption, 4: PRIO w/ preemption, 5: RR
+    int algo;           // 0 ~ MAX_ALGO, see POLICIES
+
+    int quantum;        // quantum for RR (and of the top MLFQ level, and the minimum granularity of CFS)
+    int mlfq_levels;    // MLFQ: number of levels (default 3, up to MLFQ_MAX_LEVELS)
+    int mlfq_quanta[MLFQ_MAX_LEVELS]; // MLFQ: time quantum of each level (0: quantum doubled at every level)
+    int mlfq_boost;     // MLFQ: clks between priority boosts (default 100, 0: never)
+    int cfs_latency;    // CFS: a process waking up gets up to latency/2 clks of credit (default 12)
+    double deadline_factor; // relative deadline of every process = factor x CPU burst (0: default, no deadlines)
+    int num_tasks;      // >0: the processes are the jobs of a periodic task set of num_tasks tasks (make_task_set())
+    double task_util;   // total utilization of the periodic task set (default 0.8)
+    double task_deadline; // relative deadline of the tasks = task_deadline x period (default 1: implicit deadlines)
+    bool admit;         // run the admission test on the task set first, do not simulate it if it fails
+    int tickets[MAX_PRIORITY];  // lottery/stride: tickets of priorities 1 ~ MAX_PRIORITY (0: its CFS weight)
+
+    long long max_time; // stop the simulation at this clk (0: run until every process is terminated)
+
+    int ready_q_type;   // 0: linked list, scanned by _SJF()/_PRIO()
+                        // 1: (default) indexed heap for SJF/SRTF/priority (FCFS and RR always use the list)
+                        // 2: contiguous key arrays scanned with SIMD (AVX2/SSE4.1, scalar fallback)
 
-    int quantum;        // quantum for RR
+    int engine;         // 0: (default) tick loop, advances clk by 1 every cycle
+                        // 1: event-driven, jumps clk to the next scheduling event
+    int num_cores;      // 1: (default) one CPU, >1: per-core ready queues with work stealing (tick loop only)
+    int num_devices;    // number of I/O devices (default 1), each I/O burst goes to a random one
+    int io_bursts;      // maximum number of I/O bursts per process (default 1)
+    const char* trace_file; // binary trace to replay instead of generating processes (NULL: generate)
+    int arrival_dist;   // 0: (default) uniform 1 ~ MAX_ARRIVAL_TIME (Config.rand_arrival)
+                        // 1: Poisson process, exponential inter-arrival times with mean Config.arrival_mean
+    double arrival_mean;// mean inter-arrival time of the Poisson process (default 12.5)
+    int burst_dist;     // 0: (default) uniform 1 ~ MAX_CPU_BURST (Config.rand_cpu_burst), 1: lognormal, 2: Pareto
+                        // 3: bimodal, Config.interactive_frac short interactive bursts and lognormal batch bursts
+    double burst_mean;  // mean CPU burst of the lognormal/Pareto/batch bursts (default 10)
+    double burst_shape; // lognormal: sigma of log(burst), up to 4 (default 1), Pareto: alpha, must be > 1 (default 1.5)
+    double interactive_frac; // bimodal: fraction of interactive processes (default 0.7)
+    int prio_weights[MAX_PRIORITY]; // relative weights of priorities 1 ~ MAX_PRIORITY (all 0: uniform)
+    bool keep_gannt;    // true: keep the whole gannt chart (interactive), false: only count segments (batch)
+    bool profile;       // count and sample the time of _SJF()/_PRIO()/_MLFQ()/_TOP() calls (--bench)
+    bool generic_loop;  // true: run the one simulation loop that tests algo every clk instead of the one specialized
+                        // for it (--bench-loops baseline)
+
+    bool interactive;   // true: (default) prompts and pauses for terminal input
+                        // false: batch mode (command line), runs to completion without input
+    int log_level;      // 0: no log, 1: state changes, 2: state changes and idle clks
+    bool verbose;       // true: print log messages while simulating
+    int log_size;       // number of records kept in the event log ring buffer
+    const char* log_file; // binary event log file (NULL: records stay in the ring buffer)
+    const char* timeline_file; // CPU and I/O timeline export (NULL: none), see TimelineOut
+    bool timeline_binary;   // false: Chrome trace-event JSON, true: binary TlRecs (print_timeline_file())
+    int seed;           // random seed for process creation
+    int format;         // batch summary format. 0: text, 1: json, 2: csv
 }Config;
 
+
+typedef struct LogRec{
+    /* one event log entry (rendered as text by print_log_rec()) */
+    long long clk;
+    long long arg;      // 64-bit argument (see LOG_* types)
+    int type;           // LOG_*
+    int core;           // core that logged it (-1: single CPU or I/O device)
+    int pid;
+    int pid2;           // second process (preemption)
+    int aux[3];
+}LogRec;
+
+
+typedef struct EventLog{
+    /*
+    Preallocated ring buffer of LogRecs.
+    Records are only formatted if echo is set (interactive mode) or later by print_log_rec().
+    With a sink file, full buffers are written out in binary instead of being overwritten.
+    */
+    LogRec* buf;
+    int cap;
+    int level;          // 0: off, 1: state changes, 2: + idle clks
+    bool echo;          // print records as text as soon as they are logged
+    long long total;    // number of records logged so far (next slot: total % cap)
+    long long flushed;  // number of records written to sink
+    FILE* sink;         // binary log file (NULL: oldest records are overwritten)
+}EventLog;
+
+
+// timeline export record types (TlRec.type)
+#define TL_CPU      0   // pid ran on core `track` for val clks from ts
+#define TL_IO       1   // pid was serviced by device `track` for val clks from ts
+#define TL_READY    2   // ready queue of core `track` holds val processes from ts on
+#define TL_IO_BUSY  3   // val processes are in I/O (waiting or serviced) from ts on
+#define TL_PREEMPT  4   // pid took core `track` from pid2 (back to its ready queue) at ts
+#define TL_MAGIC 0x4c545343     // "CSTL"
+#define TL_VERSION 1
+#define TL_BUF 8192             // records buffered before they are written out
+
+typedef struct TlRec{
+    /* one timeline record (32 bytes, also the record of a binary export) */
+    long long ts;       // clk
+    long long val;      // duration of a segment, value of a counter
+    int type;           // TL_*
+    int track;          // core or device
+    int pid;
+    int pid2;
+}TlRec;
+
+
+typedef struct TimelineOut{
+    /*
+    Streaming export of the CPU and I/O timeline (--timeline): CPU and device segments as they end,
+    ready queue / I/O counters when they change and preemptions. Records are buffered (TL_BUF)
+    and written out when the buffer is full, as Chrome trace-event JSON (1 clk = 1 us, opens in
+    Perfetto or chrome://tracing) or as binary TlRecs, so memory does not grow with the length of the run
+    */
+    FILE* out;
+    bool binary;
+    TlRec* buf;
+    int cnt;
+    long long total;    // records so far
+    int tracks;         // cores
+    int devices;
+    int* ready;         // last ready queue length exported of each core (-1: none yet)
+    int io_busy;        // last number of processes in I/O exported (-1: none yet)
+}TimelineOut;
+
+
+#define HIST_SUB_BITS 6         // 64 sub-buckets per power of two: exact below 128, then within 1/64
+#define HIST_BUCKETS ((64 - HIST_SUB_BITS) << HIST_SUB_BITS)
+
+typedef struct Histogram{
+    /* log-linear (HDR style) histogram of non-negative values: fixed memory, O(1) to record (hist_record()) */
+    long long cnt[HIST_BUCKETS];
+    long long n;
+    long long sum;
+    long long max;
+}Histogram;
+
+
+typedef struct Stats{
+    /* metrics of the terminated processes, recorded by retire_process() when each one terminates */
+    Histogram turnaround;
+    Histogram ready_wait;
+    Histogram io_wait;
+    Histogram response;     // first dispatch - arrival
+    // CPU share: CPU time / (CPU time + ready wait), the part of the time it wanted the CPU that a process got
+    double share_sum;       // sum of CPU shares scaled by CFS_WEIGHT_0 / weight (see cfs_weight())
+    double share_sq;        // sum of their squares (Jain's fairness index)
+    long long prio_cnt[MAX_PRIORITY];   // processes per priority (when priorities are used)
+    double prio_share[MAX_PRIORITY];    // sum of CPU shares per priority
+    // deadlines: lateness = (finish_time + 1) - (arrival_time + deadline), > 0: missed
+    Histogram lateness;     // lateness of the processes that missed their deadline
+    long long deadline_jobs;    // processes with a deadline
+    long long lateness_sum;     // lateness of all of them (negative: early)
+    // proportional share: a runnable process is entitled to tickets / ticket_total of the CPU every clk
+    long long ticket_total;     // tickets of the runnable (ready or running) processes
+    int ticket_procs;           // number of them
+    long long ticket_clock;     // CPU clks per ticket so far, in 1/2^TICKET_SHIFT clk
+    Histogram share_dev;        // |CPU clks / entitled clks - 1| of the terminated processes, in 1/1000
+}Stats;
+
+
+typedef struct Dist{
+    /* percentiles of a Histogram (upper bound of the bucket, so never under-reported) */
+    long long p50;
+    long long p95;
+    long long p99;
+    long long max;
+}Dist;
+
+
+typedef struct Eval{
+    /* metrics over the terminated processes (filled by compute_eval()) */
+    int num_process;            // number of terminated processes
+    long long finish_clk;       // clk at which the simulation ended
+    long long ready_wait_sum;
+    long long io_wait_sum;
+    long long wait_sum;         // ready + io
+    long long turnaround_sum;
+    long long response_sum;     // first dispatch - arrival
+    Dist turnaround;
+    Dist ready_wait;
+    Dist io_wait;
+    Dist response;
+    int segments;               // number of gannt chart segments (CPU bursts and idle periods), all cores
+    int num_devices;
+    long long io_bursts;        // I/O bursts completed
+    int num_cores;
+    long long migrations;       // work stealing moves between cores
+    double imbalance;           // busiest core's busy clks / average busy clks - 1 (0: perfectly balanced)
+    long long dispatches;       // scheduling decisions that put a process on a CPU
+    long long select_calls;     // _SJF()/_PRIO() calls (Config.profile)
+    double select_ns;           // average time of the sampled _SJF()/_PRIO() calls, timer included (Config.profile)
+    double fairness;            // Jain's index of the weight-scaled CPU shares (1: shares proportional to weights)
+    double utilization;         // busy clks / (finish_clk x cores)
+    long long deadline_jobs;    // processes with a deadline
+    long long deadline_misses;  // processes that finished after their deadline
+    double lateness_avg;        // average lateness of the processes with a deadline (negative: early)
+    Dist lateness;              // lateness of the misses
+    double share_dev_avg;       // average |CPU clks / entitled clks - 1| (lottery, stride)
+    Dist share_dev;             // its distribution, in 1/1000
+    double prio_share[MAX_PRIORITY]; // average CPU share per priority (0: no process)
+}Eval;
+
+
+typedef struct Event{
+    long long time; // clk at which the event occurs
+    int type;       // 0=arrival, 1=cpu burst done/io request, 2=io done, 3=quantum expiry, 4=dispatch
+    int pid;        // process the event belongs to (0 if none)
+}Event;
+
+
+typedef struct EventQueue{
+    /* binary min-heap of Events ordered by time */
+    Event* heap;
+    int cnt;
+    int cap;
+    int allocs; // number of times the heap array had to grow
+}EventQueue;
+
+
+typedef struct Device{
+    /* one I/O device: serves its FIFO wait queue one burst at a time */
+    struct Queue* wait_q;   // processes waiting for this device
+    Process* io_p;          // process being serviced (NULL: idle)
+    long long done_clk;     // clk at which io_p's burst is over (seen by wait_to_ready())
+    long long busy;         // clks spent servicing
+    bool pending;           // in DeviceSet.start
+}Device;
+
+
+typedef struct DeviceSet{
+    /*
+    All I/O devices of a simulation. Only devices that change state are touched:
+    completions come off a min-heap of done_clk, and idle devices that got a request are listed in start,
+    so the cost per clk does not depend on the number of devices
+    */
+    Device* dev;
+    int num_devices;
+    EventQueue* done;       // busy devices, Event.time: done_clk, Event.pid: device index
+    int* start;             // idle devices with waiting processes (io_service() starts them)
+    int start_cnt;
+    int busy;               // processes in I/O (waiting or being serviced)
+    long long completed;    // I/O bursts completed
+}DeviceSet;
+
+// binary trace file: TraceHeader, then `count` records in arrival order,
+// each a TraceRec followed by io_cnt IoBursts (records are 4-byte aligned, read with memcpy)
+#define TRACE_MAGIC 0x52545343  // "CSTR"
+#define TRACE_VERSION 1
+#define TRACE_CHUNK 4096        // Process slots allocated at a time while replaying
+#define TRACE_RELEASE (64<<20)  // drop pages of the mapping that were read every 64MB
+
+typedef struct TraceHeader{
+    int magic;
+    int version;
+    long long count;    // number of records
+    int max_io;         // largest io_cnt of any record
+    int devices;        // largest device index + 1 (0 if no I/O)
+}TraceHeader;
+
+
+typedef struct TraceRec{
+    long long arrival;
+    int pid;
+    int priority;
+    int cpu_burst;
+    int io_cnt;
+}TraceRec;
+
+
+typedef struct Trace{
+    /*
+    Memory-mapped trace, streamed into the arrival path: a record becomes a Process only when it is next to arrive,
+    and a terminated process goes back to the slot pool once its times are in Table.stats.
+    So memory follows the number of live processes, not the length of the trace
+    */
+    const char* map;        // whole file (read only)
+    size_t size;
+    size_t off;             // offset of the next record
+    size_t released;        // pages before this offset have been dropped from memory
+    TraceHeader hdr;
+    long long read;         // records turned into processes so far
+    Process* next;          // next process to arrive (read ahead by peek_arrival(), NULL: not read yet)
+    long long last_arrival; // records must not go back in time
+    double deadline_factor; // Config.deadline_factor: relative deadlines of the replayed processes
+
+    Process** chunk;        // Process slots, TRACE_CHUNK per chunk
+    int chunk_cnt;
+    int chunk_cap;
+    Process** free_p;       // slots of terminated processes
+    int free_cnt;
+    int free_cap;
+}Trace;
+
+
+// checkpoint: SnapHeader, then the Config, Table, Stats, gannt chart, Process and IoBurst blocks, new_pool
+// and the queues in the order snapshot_table() writes them, each section padded to 8 bytes
+// so the blocks can be copied straight out of the mapped file (same build only: struct sizes are checked)
+#define SNAP_MAGIC 0x4e535343   // "CSSN"
+#define SNAP_VERSION 1
+
+typedef struct SnapHeader{
+    int magic;
+    int version;
+    int sizes[4];       // sizeof(Process), sizeof(Queue), sizeof(Config), sizeof(Stats) of the build that wrote it
+    long long size;     // bytes, header included
+    long long clk;      // the simulation continues at this clk
+    int algo;           // algorithm it ran with so far
+    int count;          // processes (Table.pool_cnt)
+    uint64_t io_base;   // address of Table.io_block when saved: Process.io_seq is relocated from it
+}SnapHeader;
+
+
+typedef struct Snap{
+    /* snapshot being written (grows, see snapshot_table()) or read (a mapped file or a fork's buffer) */
+    char* buf;
+    size_t len;         // bytes written / readable
+    size_t cap;         // allocated (0: not owned, e.g. a mapping)
+    size_t off;         // read position
+}Snap;
+
+
+typedef struct Workload{
+    /*
+    Processes of a comparison (--compare), created once and only read by the runs: each run copies the
+    initial Process records into its own Table (its mutable overlay, see workload_table()), the I/O bursts,
+    arrival order and generator state stay shared
+    */
+    Process* proc;      // initial state of every process (never written once created)
+    IoBurst* io_block;  // their I/O bursts (NULL: loaded from a trace, the bursts stay in its mapping)
+    int* order;         // indices into proc in arrival order
+    int count;
+    int num_devices;    // devices the workload uses (a trace may raise Config.num_devices)
+    Rng rng;            // generator state after the workload was drawn (lottery draws continue from it)
+    Trace* trace;       // trace the processes were read from (NULL: generated)
+}Workload;
+
+
+typedef struct SweepTask{
+    /* one simulation of a parameter sweep (or of a comparison) */
+    Config cfg;
+    Eval ev;
+    double wall_sec;
+    const Workload* wl; // shared workload to run on (NULL: simulate() creates the processes)
+}SweepTask;
+
+
+typedef struct WorkDeque{
+    /*
+    Per-worker deque of task indices. The owner pops from the bottom,
+    idle workers steal from the top (the other end) to balance uneven run lengths
+    */
+    int* task;
+    int top;        // next task to steal
+    int bottom;     // one past the owner's next task
+    pthread_mutex_t lock;
+}WorkDeque;
+
+
+typedef struct Sweep{
+    /* shared state of the sweep thread pool */
+    SweepTask* tasks;
+    int num_tasks;
+    WorkDeque* deques;
+    int num_workers;
+    long long* steals;  // number of tasks stolen by each worker
+}Sweep;
+
+
 // function prototypes
-Process** create_process(Config *cfg);
-Process* _create_process(Config *cfg);
+void create_process(Table* tbl, Config *cfg);
+Process* _create_process(Config *cfg, Rng* rng, Process* new_process, IoBurst* io_mem);
+void generate_processes(Config *cfg, Rng* rng, Process* block, IoBurst* io_block, int count, int max_io);
+void sort_by_arrival(Process** pool, int count);
 Table* create_table(Config *cfg);
-Queue* create_queue();
+Table* create_core(Table* tbl, Config* cfg, int id);
+Queue* create_queue(int type);
+Queue* create_ready_queue(Config* cfg, long long* clk);
+void mlfq_init(Queue* q, Config* cfg);
 
 void arrived_to_ready(Table* tbl, int count);
 void wait_to_ready(Table* tbl, int algo);
+DeviceSet* create_devices(int num_devices, long long* clk);
+void request_io(DeviceSet* io, Process* p);
+Process* io_complete(Table* tbl);
 void enqueue(Queue* q, Process* p);
 void dequeue(Queue* q, Process* p);
-void update_wait_time(Table* tbl);
+void heap_push(Queue* q, Process* p);
+void heap_remove(Queue* q, Process* p);
+void array_push(Queue* q, Process* p);
+void array_remove(Queue* q, Process* p);
+void mlfq_push(Queue* q, Process* p);
+void mlfq_remove(Queue* q, Process* p);
+int mlfq_top(Queue* q);
+int argmin_key(const int* key, const long long* kseq, int n);
+void track_allocs(Table* tbl, EventQueue* eq);
 
 int CPU(Table* tbl, int algo, int _quantum);
 int io_service(Table* tbl, int algo);
 Process* _SJF(Queue* q);
 Process* _PRIO(Queue* q, Process* running_p);
+Process* _MLFQ(Queue* q);
+Process* _TOP(Queue* q);
+Process* _LOTTERY(Queue* q, Rng* rng, long long* ticket);
+void cfs_place(Queue* q, Process* p);
+int cfs_weight(int priority);
+void ticket_init(Queue* q, Config* cfg);
+void lottery_push(Queue* q, Process* p);
+void lottery_remove(Queue* q, Process* p);
+void stride_place(Queue* q, Process* p);
+void share_join(Stats* st, Process* p);
+void share_leave(Stats* st, Process* p);
+void share_clock(Stats* st, int cores, long long ticks);
+int make_task_set(Config* cfg, Rng* rng, Task* tasks);
+void generate_task_jobs(Config* cfg, Task* tasks, int num_tasks, Process* block, IoBurst* io_block, int count);
+bool admission_test(Task* tasks, int n, double* util, double* density, long long* fail_at);
 
 void print_process_info(Process *p);
 void print_queue(Queue *q);
-void evaluate(Table* tbl, int algo, int gannt_size);
-void print_gannt_chart(int gannt_size);
+void compute_eval(Table* tbl, Eval* ev);
+void evaluate(Table* tbl, int algo);
+void print_summary(Config* cfg, Eval* ev, double wall_sec, bool header);
+void gannt_record(Timeline* tl, long long clk, long long ticks, int pid);
+void print_gannt_chart(Timeline* tl);
+void print_core_stats(Table* tbl);
+
+void rng_seed(Rng* rng, uint64_t seed);
+uint64_t rng_next(Rng* rng);
+int rng_below(Rng* rng, int n);
+
+EventQueue* create_event_queue(int cap);
+void push_event(EventQueue* eq, long long time, int type, int pid);
+Event pop_event(EventQueue* eq);
+void schedule_events(Table* tbl, EventQueue* eq, int algo);
+long long next_event_time(Table* tbl, EventQueue* eq);
+void fast_forward(Table* tbl, int algo, long long ticks);
+
+void run_tick(Table* tbl, Config* cfg);
+void run_event(Table* tbl, Config* cfg);
+void run_multi(Table* tbl, Config* cfg);
+void arrived_to_cores(Table* tbl, int count);
+void io_to_core(Table* tbl);
+bool steal_work(Table* tbl, Table* core, int algo);
 
 void display_config(Config* cfg);
 void edit_config(Config* cfg);
+int run_batch(int argc, char** argv);
+int bench_select(int format);
+int bench_loops(Config* base, const char* algos, const char* nums, const char* loads);
+int run_bench(Config* base, const char* algos, const char* quanta, const char* nums, const char* loads);
+
+Trace* open_trace(const char* path, Config* cfg);
+void close_trace(Trace* tr);
+Process* peek_arrival(Table* tbl);
+void retire_process(Table* tbl, Process* p);
+void hist_record(Histogram* h, long long v);
+long long hist_percentile(Histogram* h, double q);
+void hist_dist(Histogram* h, Dist* d);
+long long terminated(Table* tbl);
+int import_csv_trace(const char* csv_path, const char* trace_path);
+int export_trace(Config* cfg, const char* trace_path);
+void free_table(Table* tbl);
+void snapshot_table(Table* tbl, Config* cfg, Snap* s);
+Table* restore_table(Snap* s, Config* cfg, bool new_policy);
+Table* fork_table(Table* tbl, Config* cfg, Config* fork_cfg);
+int save_snapshot(Table* tbl, Config* cfg, const char* path);
+Table* load_snapshot(const char* path, Config* cfg, bool new_policy);
+int run_checkpoint(Config* cfg, const char* restore_path, const char* save_path, const char* forks,
+                   bool new_policy, bool header);
+void simulate(Config* cfg, Eval* ev, double* wall_sec);
+int run_sweep(Config* base, const char* algos, const char* quanta, const char* nums, const char* seeds,
+              int num_workers, bool header);
+Workload* create_workload(Config* cfg);
+Table* workload_table(const Workload* wl, Config* cfg);
+void simulate_workload(const Workload* wl, Config* cfg, Eval* ev, double* wall_sec);
+void free_workload(Workload* wl);
+int run_compare(Config* base, const char* algos, int num_workers, bool header);
+
+EventLog* create_event_log(int cap, int level, bool echo, const char* path);
+void log_event(EventLog* log, long long clk, int core, int type, int pid, int pid2, int a0, int a1, int a2, long long arg);
+void flush_event_log(EventLog* log);
+void close_event_log(EventLog* log);
+void print_log_rec(FILE* out, LogRec* r);
+int print_log_file(const char* path);
+TimelineOut* open_timeline(const char* path, bool binary, int tracks, int devices);
+void timeline_rec(TimelineOut* tl, int type, int track, long long ts, long long val, int pid, int pid2);
+void timeline_counters(Table* tbl);
+void close_timeline(TimelineOut* tl);
+int print_timeline_file(const char* path);
 
 
 #endif  // CPU_SCHEDULER_H